@@ -2,18 +2,21 @@
 
 precision mediump float;
 
-in vec2 aPos;
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aCenter;
+layout(location = 2) in vec2 aSize;
+layout(location = 3) in vec4 aRect;
 
 out vec2 TexCoord;
 
-uniform mat4 mvp;
-uniform vec2 offset;
-uniform vec2 size;
+layout(std140) uniform Frame {
+    mat4 vp;
+};
 
 void main() {
-    gl_Position = mvp * vec4(aPos, 0.0, 1.0);
+    gl_Position = vp * vec4(aCenter + aPos * aSize, 0.0, 1.0);
 	vec2 texPos = aPos + 0.5f;
-	texPos.x = texPos.x * size.x;
-	texPos.y = texPos.y * size.y;
-    TexCoord = texPos + offset;
-}
\ No newline at end of file
+	texPos.x = texPos.x * aRect.z;
+	texPos.y = texPos.y * aRect.w;
+    TexCoord = texPos + aRect.xy;
+}
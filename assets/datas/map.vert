@@ -6,9 +6,15 @@ in vec2 aPos;
 
 out vec2 TexCoord;
 
-uniform mat4 mvp;
+layout(std140) uniform Frame {
+    mat4 vp;
+};
+
+uniform mat4 model;
+// 瓦片在纹理中的偏移与尺寸
+uniform vec4 texRect;
 
 void main() {
-    gl_Position = mvp * vec4(aPos, 0.0, 1.0);
-    TexCoord = aPos + 0.5f;
-}
\ No newline at end of file
+    gl_Position = vp * model * vec4(aPos, 0.0, 1.0);
+    TexCoord = texRect.xy + (aPos + 0.5f) * texRect.zw;
+}
@@ -0,0 +1,12 @@
+#version 300 es
+
+precision mediump float;
+
+out vec4 FragColor;
+
+// 预乘 alpha 的颜色
+uniform vec4 color;
+
+void main() {
+    FragColor = color;
+}
@@ -0,0 +1,18 @@
+#version 300 es
+
+precision mediump float;
+
+layout(location = 0) in vec2 aPos;
+// 折线的法向偏移，拐角处为按斜接长度缩放后的方向
+layout(location = 1) in vec2 aNormal;
+
+layout(std140) uniform Frame {
+    mat4 vp;
+};
+
+// 线宽的一半（地图像素）
+uniform float halfWidth;
+
+void main() {
+    gl_Position = vp * vec4(aPos + aNormal * halfWidth, 0.0, 1.0);
+}
@@ -1,12 +1,12 @@
 #include "AssetUtils.h"
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 
-#include <SDL_log.h>
-#include <SDL_assert.h>
 #include <set>
 
-using JsonMember = std::decay_t<decltype(*(rapidjson::Value{}.MemberBegin()))>;
+#include "LogUtils.h"
+#include "Profiler.h"
 
 std::string TEX_DIR(const std::string& fname_) {
     std::string name(fname_);
@@ -20,16 +20,29 @@ std::string DATA_DIR(const std::string& fname_) {
     return std::string("assets/datas/") + name;
 }
 
-bool LoadJson(const char* fname, rapidjson::Document& doc) {
+bool ReadData(const char* fname, std::vector<char>& text) {
     std::string path = DATA_DIR(fname);
-    std::ifstream ss(path);
+    std::ifstream ss(path, std::ios::binary | std::ios::ate);
     if (!ss.is_open()) {
-        SDL_Log("Could not open the file %s\n", path.c_str());
+        LogInfo("Could not open the file %s\n", path.c_str());
         return false;
     }
-    using isb_iter = std::istreambuf_iterator<char>;
-    std::string content{ isb_iter(ss), isb_iter() };
-    doc.Parse(content.c_str());
+    size_t size = (size_t)ss.tellg();
+    ss.seekg(0);
+    text.resize(size + 1);
+    if (!ss.read(text.data(), size)) {
+        LogInfo("Failed to read the file %s\n", path.c_str());
+        return false;
+    }
+    text[size] = '\0';
+    return true;
+}
+
+bool LoadJson(const char* fname, std::vector<char>& text, rapidjson::Document& doc) {
+    PROFILE_SCOPE("LoadJson");
+    if (!ReadData(fname, text))
+        return false;
+    doc.ParseInsitu(text.data());
     return !doc.HasParseError();
 }
 
@@ -48,11 +61,36 @@ JsonAsset::~JsonAsset() {
 }
 
 void JsonAsset::Cleanup() {
-    rapidjson::Document().Swap(m_Document);
+    m_Document = rapidjson::Document();
+    m_Allocator.reset();
+    std::vector<char>().swap(m_Arena);
+    std::vector<char>().swap(m_Text);
+    m_ArenaUsed = 0;
+}
+
+void JsonAsset::Reset() {
+    m_Document = rapidjson::Document();
+    if (!m_Allocator || m_ArenaUsed > m_Arena.size()) {
+        // 多留一些余量，同一文件再次加载时不必再分配新的块
+        m_Allocator.reset();
+        if (m_ArenaUsed > 0)
+            std::vector<char>(m_ArenaUsed + m_ArenaUsed / 8).swap(m_Arena);
+        if (m_Arena.empty())
+            m_Allocator = std::make_unique<Allocator>();
+        else
+            m_Allocator = std::make_unique<Allocator>(m_Arena.data(), m_Arena.size());
+    }
+    else {
+        m_Allocator->Clear();
+    }
+    m_Document = rapidjson::Document(m_Allocator.get());
 }
 
 bool JsonAsset::Load(const char* fname) {
-    return ::LoadJson(fname, m_Document);
+    Reset();
+    bool result = ::LoadJson(fname, m_Text, m_Document);
+    m_ArenaUsed = std::max(m_ArenaUsed, m_Allocator->Size());
+    return result;
 }
 
 void Variables::Initialize() {
@@ -74,6 +112,30 @@ void Variables::Initialize() {
     }
 }
 
+const char* GetIconName(IconKind kind) {
+    static const char* names[eIconKindCount] = {
+        "Padding 1",
+        "Padding 2",
+        "Rot Blessing",
+        "Boss",
+        "Red Boss",
+        "Evergaol",
+        "Camp",
+        "Small Camp",
+        "Church",
+        "Great Church",
+        "Township",
+        "Sorcerer's Rise",
+        "Ruins",
+        "Fort",
+        "Circle",
+        "Cart",
+        "Demon Merchant",
+        nullptr,
+    };
+    return names[kind];
+}
+
 void IconAtlas::Initialize() {
     m_Json.Load("icons.json");
     auto& doc = m_Json.GetDoc();
@@ -94,6 +156,11 @@ void IconAtlas::Initialize() {
 
         m_Icons[name] = glm::ivec4(offset, size);
     }
+
+    for (int i = 0; i < eIconKindCount; i++) {
+        const char* name = GetIconName((IconKind)i);
+        m_Kinds[i] = name ? QueryIcon(name) : nullptr;
+    }
 }
 
 const glm::ivec4* IconAtlas::QueryIcon(const char* name) const {
@@ -103,195 +170,100 @@ const glm::ivec4* IconAtlas::QueryIcon(const char* name) const {
     return &iter->second;
 }
 
-static std::string LOC_PATH(const char* name) {
-    return std::string("loc ") + name + ".json";
-}
-
-static std::string MAP_PATH(const char* name) {
-    return std::string("map ") + name + ".json";
-}
-
-void MapThumbnail::LoadMap(const char* mapName) {
-    m_Json.Load(MAP_PATH(mapName).c_str());
-    m_Locations.clear();
-    LoadLocation(eMinorBase, "Minor Base", "Minor Base");
-    LoadLocation(eMajorBase, "Major Base", "Major Base");
-    LoadLocation(eEvergaol, "Evergaol", "Evergaol");
-    LoadLocation(eFieldBoss, "Field Boss", "Field Boss");
-    LoadLocation(eCircle, "Circle", "Night 1 Circle");
-    LoadLocation(eCircle, "Circle", "Night 2 Circle");
-    LoadLocation(eRottedWoods, "Rotted Woods", "Rotted Woods");
-    LoadLocation(eRotBlessing, "Rot Blessing", "Rot Blessing");
-    LoadLocation(eFrenzyTower, "Frenzy Tower", "Frenzy Tower");
-    LoadLocation(eDemonMerchant, "Demon Merchant", "Scale-Bearing Merchant");
-}
-
-void MapThumbnail::Foreach(MapFilter&& filter) {
-    auto mapList = m_Json.GetDoc().GetArray();
-    std::for_each(mapList.Begin(), mapList.End(), filter);
-}
-
-const rapidjson::Value* MapThumbnail::Find(MapFinder&& finder) {
-    auto mapList = m_Json.GetDoc().GetArray();
-    return std::find_if(mapList.Begin(), mapList.End(), finder);
-}
-
-std::string_view MapThumbnail::Near(const char* locName) const {
-    std::string_view majorCamp;
-
-    auto minorItr = m_Locations.find(LocationType::eMinorBase);
-    auto majorItr = m_Locations.find(LocationType::eMajorBase);
-    if (minorItr == m_Locations.end() || majorItr == m_Locations.end())
-        return majorCamp;
-
-    auto itr = minorItr->second.find(locName);
-    if (itr == minorItr->second.end())
-        return majorCamp;
-
-    using ValueType = decltype(*majorItr->second.begin());
-    auto& pos = itr->second;
-    float dis = FLT_MAX;
-    std::for_each(majorItr->second.begin(), majorItr->second.end(),
-        [&pos,&dis,&majorCamp](ValueType& value) {
-            float newdis = glm::distance(
-                glm::vec2(pos),
-                glm::vec2(value.second));
-            if (newdis < 1)
-                return;
-
-            if (newdis < dis) {
-                majorCamp = value.first;
-                dis = newdis;
-            }
-        }
-    );
-
-    return majorCamp;
+bool MapThumbnail::LoadMap(const SeedDatabase& database, const char* mapName) {
+    PROFILE_SCOPE("MapThumbnail::LoadMap");
+    m_Database = &database;
+    m_Terrain = database.FindTerrain(mapName);
+    if (!m_Terrain) {
+        m_Locations.Clear();
+        LogInfo("Could not find the map %s\n", mapName);
+        return false;
+    }
+    m_Locations.Build(database, *m_Terrain);
+    return true;
 }
 
-void MapThumbnail::LoadLocation(LocationType loc, const char* source, const char* key) {
-    auto& target = m_Locations[loc];
-
-    std::unordered_set<std::string_view> exist;
-    Foreach([&exist, key](const rapidjson::Value& member) {
-        auto itr = member.FindMember(key);
-        if (itr == member.MemberEnd())
-            return;
-        auto& value = itr->value;
-        if (value.IsNull())
-            return;
-        if (value.IsString()) {
-            exist.insert(value.GetString());
-        }
-        else if(value.IsObject()) {
-            for (auto subItr = value.MemberBegin();
-                subItr != value.MemberEnd(); ++subItr) {
-                if (!subItr->name.IsString())
-                    continue;
-                exist.insert(subItr->name.GetString());
-            }
-        }
-    });
-
-    JsonAsset mlocJson;
-    mlocJson.Load(LOC_PATH(source).c_str());
-
-    auto& mlocDoc = mlocJson.GetDoc();
-    std::for_each(mlocDoc.MemberBegin(), mlocDoc.MemberEnd(),
-        [&target,&exist](const JsonMember& member) {
-            if (!member.value.IsString())
-                return;
-            auto itr = exist.find(member.name.GetString());
-            if (itr == exist.end())
-                return;
-            std::string_view key = *itr;
-            toivec2(target[key], member.value.GetString());
-        }
-    );
+void MapThumbnail::Foreach(MapFilter&& filter) const {
+    if (!m_Terrain)
+        return;
+    for (uint32_t i = 0; i < m_Terrain->seedCount; i++) {
+        filter(m_Database->Seed(*m_Terrain, i));
+    }
 }
 
-namespace VisitJson
-{
-const char* getstr(const rapidjson::Value* value, const char* key) {
-    const char* nulString = "";
-    if (!value)
-        return nulString;
-    auto itr = value->FindMember(key);
-    if (itr == value->MemberEnd())
-        return nulString;
-    if (!itr->value.IsString())
-        return nulString;
-    return itr->value.GetString();
+const EmdbSeed* MapThumbnail::Find(MapFinder&& finder) const {
+    if (!m_Terrain)
+        return nullptr;
+    for (uint32_t i = 0; i < m_Terrain->seedCount; i++) {
+        auto& seed = m_Database->Seed(*m_Terrain, i);
+        if (finder(seed))
+            return &seed;
+    }
+    return nullptr;
 }
 
-const rapidjson::Value* getobj(const rapidjson::Value* value, const char* key) {
-    const rapidjson::Value* nulObject = nullptr;
-    if (!value)
-        return nulObject;
-    auto itr = value->FindMember(key);
-    if (itr == value->MemberEnd())
-        return nulObject;
-    if (!itr->value.IsObject())
-        return nulObject;
-    return &itr->value;
+uint16_t MapThumbnail::Near(uint16_t minorBase) const {
+    // 跳过与营地重合的 Major Base
+    for (const auto& neighbor : m_Locations.Nearest(eMinorBase, minorBase, eMajorBase)) {
+        if (neighbor.distance >= 1)
+            return neighbor.id;
+    }
+    return EMDB_NO_LOCATION;
 }
 
+uint16_t MapThumbnail::FindLocation(LocationType loc, const char* locName) const {
+    if (!locName || strlen(locName) == 0)
+        return EMDB_NO_LOCATION;
+    for (uint16_t id = 0; id < LocationCount(loc); id++) {
+        if (IsPresent(loc, id) && strcmp(Name(loc, id), locName) == 0)
+            return id;
+    }
+    return EMDB_NO_LOCATION;
 }
 
-void MapDetail::Load(const rapidjson::Value& value, const MapThumbnail& thumbnail) {
-    using namespace VisitJson;
-
-    auto visit = [&value, &thumbnail](const char* key,
-        LocationType locType, MapLocations& target) {
-        auto sub = getobj(&value, key);
-        if (!sub) return;
-        for (auto itr = sub->MemberBegin();
-            itr != sub->MemberEnd(); ++itr) {
-            auto& mem = *itr;
-            if (!mem.name.IsString() || !mem.value.IsString())
-                continue;
-            auto pos = thumbnail.Query(locType, mem.name.GetString());
+void MapDetail::Load(const EmdbSeed& seed, const MapThumbnail& thumbnail) {
+    auto visit = [&seed, &thumbnail](LocationType locType, MapLocations& target) {
+        for (uint16_t id = 0; id < thumbnail.LocationCount(locType); id++) {
+            auto pos = thumbnail.Query(locType, id);
             if (!pos)
                 continue;
-            target[glm::vec2(*pos)] = mem.value.GetString();
+            uint16_t value = thumbnail.ValueOf(seed, locType, id);
+            if (value == EMDB_EMPTY_STRING)
+                continue;
+            target[glm::vec2(*pos)] = thumbnail.String(value);
         }
     };
 
-    nightlord = getstr(&value, "Nightlord");
-    if (auto pos = thumbnail.Query(eMinorBase, getstr(&value, "Spawn Point"))) {
+    index = seed.index;
+    nightlord = thumbnail.String(seed.nightlord);
+    if (auto pos = thumbnail.Query(eMinorBase, seed.spawn_point)) {
         spawn_point = *pos;
     }
-    special_event = getstr(&value, "Special Event");
-    night_1_boss = getstr(&value, "Night 1 Boss");
-    night_2_boss = getstr(&value, "Night 2 Boss");
-    extra_boss = getstr(&value, "Extra Night Boss");
-    if (auto pos = thumbnail.Query(eCircle, getstr(&value, "Night 1 Circle"))) {
+    special_event = thumbnail.String(seed.special_event);
+    night_1_boss = thumbnail.String(seed.night_1_boss);
+    night_2_boss = thumbnail.String(seed.night_2_boss);
+    extra_boss = thumbnail.String(seed.extra_boss);
+    if (auto pos = thumbnail.Query(eCircle, seed.night_1_circle)) {
         day_1_circle = *pos;
     }
-    if (auto pos = thumbnail.Query(eCircle, getstr(&value, "Night 2 Circle"))) {
+    if (auto pos = thumbnail.Query(eCircle, seed.night_2_circle)) {
         day_2_circle = *pos;
     }
-    if (auto sub = getobj(&value, "Castle")) {
-        castle_type = getstr(sub, "Castle");
-    }
-    visit("Minor Base", eMinorBase, minor);
-    visit("Major Base", eMajorBase, major);
-    visit("Evergaol", eEvergaol, evergaol);
-    if (auto sub = getobj(&value, "Arena Boss")) {
-        castle_basement = getstr(sub, "Castle Basement");
-    }
-    if (auto sub = getobj(&value, "Field Boss")) {
-        castle_rooftop = getstr(sub, "Castle Rooftop");
-    }
-    visit("Field Boss", eFieldBoss, field);
-    visit("Rotted Woods", eRottedWoods, rotted_woods);
-    if (auto pos = thumbnail.Query(eRotBlessing, getstr(&value, "Rot Blessing"))) {
+    castle_type = thumbnail.String(seed.castle_type);
+    visit(eMinorBase, minor);
+    visit(eMajorBase, major);
+    visit(eEvergaol, evergaol);
+    castle_basement = thumbnail.String(seed.castle_basement);
+    castle_rooftop = thumbnail.String(seed.castle_rooftop);
+    visit(eFieldBoss, field);
+    visit(eRottedWoods, rotted_woods);
+    if (auto pos = thumbnail.Query(eRotBlessing, seed.rot_blessing)) {
         rot_blessing = *pos;
     }
-    if (auto pos = thumbnail.Query(eFrenzyTower, getstr(&value, "Frenzy Tower"))) {
+    if (auto pos = thumbnail.Query(eFrenzyTower, seed.frenzy_tower)) {
         frenzy_tower = *pos;
     }
-    if (auto pos = thumbnail.Query(eDemonMerchant, getstr(&value, "Scale-Bearing Merchant"))) {
+    if (auto pos = thumbnail.Query(eDemonMerchant, seed.demon_merchant)) {
         demon_merchant = *pos;
     }
 }
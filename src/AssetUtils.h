@@ -1,22 +1,36 @@
 #pragma once
 
+#include <cfloat>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
+#include <memory>
 #include <vector>
 #include <functional>
 
 #include <glm/glm.hpp>
 #include <rapidjson/document.h>
 
+#include "LocationIndex.h"
+#include "SeedDatabase.h"
+
 std::string TEX_DIR(const std::string& fname);
 std::string DATA_DIR(const std::string& fname);
 
-bool LoadJson(const char* fname, rapidjson::Document& doc);
+// 一次读入 DATA_DIR 下的整个文件，末尾补 0 以便原地解析
+bool ReadData(const char* fname, std::vector<char>& text);
+// 读入 text 后原地解析，doc 中的字符串直接指向 text
+bool LoadJson(const char* fname, std::vector<char>& text, rapidjson::Document& doc);
+bool toivec2(glm::ivec2& result, const std::string& str);
 
+// 文件内容与 DOM 节点都归 JsonAsset 所有：字符串原地解析不再复制，
+// 节点从一块随加载增长的内存池中分配。重复 Load 时复用这两块内存，Cleanup 才释放
 class JsonAsset {
 public:
+	JsonAsset() = default;
+	JsonAsset(const JsonAsset&) = delete;
+	JsonAsset& operator=(const JsonAsset&) = delete;
 	~JsonAsset();
 	void Cleanup();
 	bool Load(const char* fname);
@@ -25,6 +39,16 @@ public:
 	}
 
 private:
+	using Allocator = rapidjson::MemoryPoolAllocator<>;
+
+	// 清空上一次的内容，内存池不足以容纳上一次的节点时整块扩大
+	void Reset();
+
+private:
+	std::vector<char> m_Text;
+	std::vector<char> m_Arena;
+	std::unique_ptr<Allocator> m_Allocator;
+	size_t m_ArenaUsed = 0; // 上一次解析用掉的内存池字节数
 	rapidjson::Document m_Document;
 };
 
@@ -45,60 +69,111 @@ private:
     NameList m_Nightlords;
 };
 
+// 地图上使用的图标种类，IconAtlas 初始化时一次性解析为图集矩形
+enum IconKind {
+	eIconPadding1,
+	eIconPadding2,
+	eIconRotBlessing,
+	eIconBoss,
+	eIconRedBoss,
+	eIconEvergaol,
+	eIconCamp,
+	eIconSmallCamp,
+	eIconChurch,
+	eIconGreatChurch,
+	eIconTownship,
+	eIconSorcerersRise,
+	eIconRuins,
+	eIconFort,
+	eIconCircle,
+	eIconCart,
+	eIconDemonMerchant,
+	eIconNone, // 没有对应的图标，不绘制
+
+	eIconKindCount,
+};
+
+// icons.json 中的名字，eIconNone 返回 nullptr
+const char* GetIconName(IconKind kind);
+
 class IconAtlas {
 public:
 	using Rects = std::unordered_map<std::string_view, glm::ivec4>;
 	void Initialize();
 	const glm::ivec4* QueryIcon(const char* name) const;
+	// 图集中缺失时返回 nullptr
+	const glm::ivec4* QueryIcon(IconKind kind) const {
+		return m_Kinds[kind];
+	}
 
 private:
 	JsonAsset m_Json;
 	Rects m_Icons;
-};
-
-enum LocationType {
-    eMinorBase,
-    eMajorBase,
-    eEvergaol,
-    eFieldBoss,
-    eCircle,
-    eRottedWoods,
-    eRotBlessing,
-    eFrenzyTower,
-    eDemonMerchant,
+	const glm::ivec4* m_Kinds[eIconKindCount]{};
 };
 
 class MapThumbnail {
 public:
-	using Locations = std::unordered_map<std::string_view, glm::ivec2>;
-	using Places = std::vector<std::string_view>;
-	using MapFilter = std::function<void(const rapidjson::Value&)>;
-	using MapFinder = std::function<bool(const rapidjson::Value&)>;
+	using MapFilter = std::function<void(const EmdbSeed&)>;
+	using MapFinder = std::function<bool(const EmdbSeed&)>;
 
-	void LoadMap(const char* mapName);
+	bool LoadMap(const SeedDatabase& database, const char* mapName);
 	
-	void Foreach(MapFilter&& filter);
-	const rapidjson::Value* Find(MapFinder&& finder);
+	void Foreach(MapFilter&& filter) const;
+	const EmdbSeed* Find(MapFinder&& finder) const;
+	uint32_t SeedCount() const {
+		return m_Terrain ? m_Terrain->seedCount : 0;
+	}
+	const EmdbSeed& Seed(uint32_t i) const {
+		return m_Database->Seed(*m_Terrain, i);
+	}
 
-	const glm::ivec2* Query(LocationType loc, const char* locName) const {
-		if (!locName || strlen(locName) == 0)
+	const glm::ivec2* Query(LocationType loc, uint16_t id) const {
+		if (!IsPresent(loc, id))
 			return nullptr;
-		auto typeItr = m_Locations.find(loc);
-		if (typeItr == m_Locations.end())
-			return nullptr;
-		auto itr = typeItr->second.find(locName);
-		if (itr == typeItr->second.end())
-			return nullptr;
-		return &itr->second;
+		return &m_Database->Location(loc, id).pos;
+	}
+	const char* Name(LocationType loc, uint16_t id) const {
+		if (!IsPresent(loc, id))
+			return "";
+		return m_Database->String(m_Database->Location(loc, id).name);
+	}
+	const char* String(uint16_t id) const {
+		return m_Database->String(id);
+	}
+	// 种子在指定地点的取值（字符串 id），如 Minor Base 某处的营地类型
+	uint16_t ValueOf(const EmdbSeed& seed, LocationType loc, uint16_t id) const {
+		return m_Database->Value(seed, loc, id);
+	}
+	uint16_t LocationCount(LocationType loc) const {
+		return (uint16_t)m_Database->Type(loc).count;
 	}
-	std::string_view Near(const char* locName) const;
+	// 该落地点的识别决策树，没有时返回空
+	const EmdbTree* Tree(uint16_t spawn) const {
+		return m_Terrain ? m_Database->FindTree(*m_Terrain, spawn) : nullptr;
+	}
+	const SeedDatabase* Database() const {
+		return m_Database;
+	}
+	// 离 Minor Base 地点最近的 Major Base 地点 id，查近邻表（第一次调用时生成）
+	uint16_t Near(uint16_t minorBase) const;
+	// 载入地形时建立的地点近邻索引
+	const LocationIndex& Locations() const {
+		return m_Locations;
+	}
+	// 地点名到地点 id，仅用于外部输入，渲染与筛选路径直接使用 id
+	uint16_t FindLocation(LocationType loc, const char* locName) const;
 
 private:
-	void LoadLocation(LocationType loc, const char* source, const char* key);
+	bool IsPresent(LocationType loc, uint16_t id) const {
+		return m_Terrain && id < LocationCount(loc)
+			&& (m_Terrain->present[loc] & (1u << id));
+	}
 	
 private:
-	JsonAsset m_Json;
-	std::map<LocationType, Locations> m_Locations;
+	const SeedDatabase* m_Database = nullptr;
+	const EmdbTerrain* m_Terrain = nullptr;
+	LocationIndex m_Locations;
 };
 
 struct PosComp {
@@ -132,6 +207,10 @@ struct MapDetail {
 	glm::vec2 frenzy_tower{};
 	glm::vec2 demon_merchant{};
 
-	void Load(const rapidjson::Value& value, const MapThumbnail& thumbnail);
+	void Load(const EmdbSeed& seed, const MapThumbnail& thumbnail);
 	void Reset();
+	// Reset 后缺失的坐标为 FLT_MAX
+	static bool IsPresent(const glm::vec2& pos) {
+		return pos.x != FLT_MAX;
+	}
 };
\ No newline at end of file
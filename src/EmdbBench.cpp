@@ -0,0 +1,266 @@
+// 地形切换耗时对比：
+//   parse     仅读取并原地解析 map *.json（复用同一个 JsonAsset），两种 json 加载方式的共同开销
+//   legacy    旧版 MapThumbnail::LoadMap，每个字段各扫描一遍种子并重新读取 loc *.json
+//   compiler  SeedCompiler::LoadTerrain，单次遍历且地点文件进程内只读一次；
+//             除地点坐标外还写出完整的种子记录，比 legacy 多做了字段值去重
+//   emdb      MapThumbnail::LoadMap，直接映射 seeds.emdb
+// 以及跨地形搜索（SeedSearch）按夜王查询全部地形的耗时，
+// 相似种子查询（SeedSimilarity）的耗时与每个地形的聚类报告，
+// 以及经过全部 Major Base、永夜牢与野外 Boss 的路线规划（RoutePlanner）耗时
+// 用法: emdb_bench [iterations]，需在包含 assets 目录的路径下运行
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "AssetUtils.h"
+#include "RoutePlanner.h"
+#include "SeedDatabase.h"
+#include "SeedSearch.h"
+#include "SeedSimilarity.h"
+
+class LegacyThumbnail {
+public:
+    void LoadMap(const char* mapName) {
+        m_Json.Load((std::string("map ") + mapName + ".json").c_str());
+        m_Locations.clear();
+        LoadLocation(eMinorBase, "Minor Base", "Minor Base");
+        LoadLocation(eMajorBase, "Major Base", "Major Base");
+        LoadLocation(eEvergaol, "Evergaol", "Evergaol");
+        LoadLocation(eFieldBoss, "Field Boss", "Field Boss");
+        LoadLocation(eCircle, "Circle", "Night 1 Circle");
+        LoadLocation(eCircle, "Circle", "Night 2 Circle");
+        LoadLocation(eRottedWoods, "Rotted Woods", "Rotted Woods");
+        LoadLocation(eRotBlessing, "Rot Blessing", "Rot Blessing");
+        LoadLocation(eFrenzyTower, "Frenzy Tower", "Frenzy Tower");
+        LoadLocation(eDemonMerchant, "Demon Merchant", "Scale-Bearing Merchant");
+    }
+
+private:
+    void LoadLocation(LocationType loc, const char* source, const char* key) {
+        auto& target = m_Locations[loc];
+
+        std::unordered_set<std::string_view> exist;
+        for (const auto& member : m_Json.GetDoc().GetArray()) {
+            auto itr = member.FindMember(key);
+            if (itr == member.MemberEnd())
+                continue;
+            auto& value = itr->value;
+            if (value.IsString()) {
+                exist.insert(value.GetString());
+            }
+            else if (value.IsObject()) {
+                for (auto subItr = value.MemberBegin();
+                    subItr != value.MemberEnd(); ++subItr) {
+                    if (subItr->name.IsString())
+                        exist.insert(subItr->name.GetString());
+                }
+            }
+        }
+
+        JsonAsset mlocJson;
+        mlocJson.Load((std::string("loc ") + source + ".json").c_str());
+        auto& mlocDoc = mlocJson.GetDoc();
+        for (auto itr = mlocDoc.MemberBegin(); itr != mlocDoc.MemberEnd(); ++itr) {
+            if (!itr->value.IsString())
+                continue;
+            auto existItr = exist.find(itr->name.GetString());
+            if (existItr == exist.end())
+                continue;
+            toivec2(target[*existItr], itr->value.GetString());
+        }
+    }
+
+private:
+    JsonAsset m_Json;
+    std::map<LocationType, std::unordered_map<std::string_view, glm::ivec2>> m_Locations;
+};
+
+// 相似种子查询返回的种子数与聚类报告的簇数
+static constexpr uint32_t SIMILAR_COUNT = 5;
+static constexpr uint32_t CLUSTER_COUNT = 6;
+
+template<class Func>
+static double Measure(int iterations, Func&& func) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        func();
+    }
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 20;
+
+    Variables variables;
+    variables.Initialize();
+
+    SeedDatabase database;
+    if (!database.Open("seeds.emdb"))
+        database.Build(variables.GetTerrains());
+
+    // 预热进程内地点缓存
+    SeedCompiler().LoadTerrain(variables.GetTerrains().front());
+
+    printf("%-14s %12s %12s %12s %12s\n", "terrain",
+        "parse(ms)", "legacy(ms)", "compiler(ms)", "emdb(us)");
+    for (auto name : variables.GetTerrains()) {
+        std::string terrain(name);
+
+        JsonAsset json;
+        double parse = Measure(iterations, [&json, &terrain]() {
+            json.Load(("map " + terrain + ".json").c_str());
+        });
+        double legacy = Measure(iterations, [&terrain]() {
+            LegacyThumbnail thumbnail;
+            thumbnail.LoadMap(terrain.c_str());
+        });
+        double compiler = Measure(iterations, [&terrain]() {
+            SeedCompiler seeds;
+            seeds.LoadTerrain(terrain);
+        });
+        double emdb = Measure(iterations * 1000, [&database, &terrain]() {
+            MapThumbnail thumbnail;
+            thumbnail.LoadMap(database, terrain.c_str());
+        });
+
+        printf("%-14s %12.3f %12.3f %12.3f %12.3f\n", terrain.c_str(),
+            parse, legacy, compiler, emdb * 1000.0);
+    }
+
+    SeedSearch search;
+    double load = Measure(1, [&]() {
+        search.Load(database, variables.GetTerrains());
+    });
+    printf("\n%-14s %12s %12s %12s\n", "nightlord", "load(ms)", "search(us)", "matches");
+    std::vector<SeedMatch> matches;
+    for (uint16_t nightlord : search.Values(eSeedNightlord)) {
+        SeedQuery query;
+        query.Where(eSeedNightlord, nightlord);
+        double elapsed = Measure(iterations * 100, [&]() {
+            search.Run(query, matches);
+        });
+        printf("%-14s %12.3f %12.3f %12u\n", database.String(nightlord),
+            load, elapsed * 1000.0, (unsigned)matches.size());
+    }
+
+    // similar 为按种子查最相似的种子，observe 为按一组无种子完全满足的观察查最接近的种子，
+    // nearest 为每个种子到最相似种子的平均距离
+    printf("\n%-14s %10s %10s %12s %12s %10s %10s\n", "similarity", "features", "bits",
+        "similar(us)", "observe(us)", "distance", "nearest");
+    std::vector<SeedSimilarity> similarities(search.TerrainCount());
+    for (uint32_t t = 0; t < search.TerrainCount(); t++) {
+        auto& similarity = similarities[t];
+        const auto& index = search.Index(t);
+        similarity.Build(index);
+        if (similarity.SeedCount() < 2)
+            continue;
+
+        std::vector<SeedDistance> nearest;
+        uint32_t seed = 0;
+        double similar = Measure(iterations * 100, [&]() {
+            similarity.Nearest(seed, SIMILAR_COUNT, nearest);
+            seed = (seed + 1) % similarity.SeedCount();
+        });
+        double mean = 0;
+        for (uint32_t i = 0; i < similarity.SeedCount(); i++) {
+            similarity.Nearest(i, 1, nearest);
+            mean += nearest[0].distance;
+        }
+        mean /= similarity.SeedCount();
+
+        // 第一个种子的全部 Major Base，其中第一个换成另一种营地，模拟看错了一处
+        const auto& thumbnail = search.Thumbnail(t);
+        SeedQuery query;
+        bool misread = false;
+        for (uint16_t slot = 0; slot < index.SlotCount(eSeedMajorBase); slot++) {
+            const auto& values = index.Values(eSeedMajorBase, slot);
+            if (values.size() < 2)
+                continue;
+            uint16_t value = GetSeedValue(thumbnail, thumbnail.Seed(0), eSeedMajorBase, slot);
+            if (!misread) {
+                value = value == values[0] ? values[1] : values[0];
+                misread = true;
+            }
+            query.Where(eSeedMajorBase, slot, value);
+        }
+        double observe = Measure(iterations * 100, [&]() {
+            similarity.Nearest(query, SIMILAR_COUNT, nearest);
+        });
+        printf("%-14s %10u %10u %12.3f %12.3f %10u %10.2f\n",
+            std::string(search.TerrainName(t)).c_str(), similarity.FeatureCount(),
+            similarity.BitCount(), similar * 1000.0, observe * 1000.0,
+            nearest.empty() ? 0u : nearest[0].distance, mean);
+    }
+
+    // 每个地形的聚类报告，按簇大小降序
+    std::vector<SeedCluster> clusters;
+    for (uint32_t t = 0; t < search.TerrainCount(); t++) {
+        similarities[t].Cluster(CLUSTER_COUNT, clusters);
+        std::sort(clusters.begin(), clusters.end(),
+            [](const SeedCluster& l, const SeedCluster& r) {
+                return l.seeds.size() > r.seeds.size();
+            });
+        printf("\n%-14s %10s %10s %10s\n", std::string(search.TerrainName(t)).c_str(),
+            "seeds", "medoid", "spread");
+        for (const auto& cluster : clusters) {
+            printf("%-14s %10u %10u %10.2f\n", "", (unsigned)cluster.seeds.size(),
+                (unsigned)search.Thumbnail(t).Seed(cluster.medoid).index, cluster.spread);
+        }
+    }
+
+    // 每个地形依次为全部种子规划路线：reset 为预计算距离矩阵，
+    // plan 与 max 为单次规划的平均与最长耗时，stops 为平均途经点数，ratio 为相对最近邻路线的长度
+    printf("\n%-14s %10s %10s %10s %10s %10s %10s\n", "route", "points", "reset(us)",
+        "plan(us)", "max(us)", "stops", "ratio");
+    for (uint32_t t = 0; t < search.TerrainCount(); t++) {
+        const auto& thumbnail = search.Thumbnail(t);
+        if (thumbnail.SeedCount() == 0)
+            continue;
+        RoutePlanner planner;
+        double reset = Measure(iterations, [&]() {
+            planner.Reset(thumbnail);
+        });
+
+        std::vector<glm::vec2> route;
+        double total = 0, worst = 0, stops = 0, ratio = 0;
+        for (uint32_t i = 0; i < thumbnail.SeedCount(); i++) {
+            const auto& seed = thumbnail.Seed(i);
+            double elapsed = Measure(1, [&]() {
+                planner.Plan(seed, RoutePlanner::STOP_TYPES, route);
+            });
+            total += elapsed;
+            worst = std::max(worst, elapsed);
+            if (route.size() < 2)
+                continue;
+            stops += route.size() - 2;
+
+            // 同一组途经点按最近邻顺序的长度
+            float planned = 0;
+            for (size_t k = 1; k < route.size(); k++) {
+                planned += glm::distance(route[k - 1], route[k]);
+            }
+            std::vector<glm::vec2> rest(route.begin() + 1, route.end() - 1);
+            glm::vec2 at = route.front();
+            float greedy = 0;
+            while (!rest.empty()) {
+                auto next = std::min_element(rest.begin(), rest.end(),
+                    [&at](const glm::vec2& l, const glm::vec2& r) {
+                        return glm::distance(at, l) < glm::distance(at, r);
+                    });
+                greedy += glm::distance(at, *next);
+                at = *next;
+                rest.erase(next);
+            }
+            greedy += glm::distance(at, route.back());
+            ratio += greedy > 0 ? planned / greedy : 1.0;
+        }
+        uint32_t count = thumbnail.SeedCount();
+        printf("%-14s %10u %10.3f %10.3f %10.3f %10.1f %10.3f\n",
+            std::string(search.TerrainName(t)).c_str(), planner.PointCount(),
+            reset * 1000.0, total / count * 1000.0, worst * 1000.0, stops / count, ratio / count);
+    }
+    return 0;
+}
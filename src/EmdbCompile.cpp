@@ -0,0 +1,35 @@
+// 离线编译 assets/datas 下的 map *.json 与 loc *.json 为 seeds.emdb
+// 用法: emdb_compile <output> [distance weight]，需在包含 assets 目录的路径下运行
+// distance weight 为决策树中离落地点每 1000 像素额外计入的检查代价
+#include <cstdlib>
+#include <fstream>
+
+#include "AssetUtils.h"
+#include "LogUtils.h"
+#include "SeedDatabase.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        LogInfo("usage: emdb_compile <output> [distance weight]\n");
+        return 1;
+    }
+
+    Variables variables;
+    variables.Initialize();
+
+    float distanceWeight = argc > 2 ? (float)atof(argv[2]) : 0.f;
+    std::vector<char> image;
+    if (!SeedDatabase::Compile(variables.GetTerrains(), image, distanceWeight)) {
+        LogInfo("Failed to compile seed database\n");
+        return 1;
+    }
+
+    std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LogInfo("Could not open the file %s\n", argv[1]);
+        return 1;
+    }
+    out.write(image.data(), image.size());
+    LogInfo("Compile Database %s (%u bytes)\n", argv[1], (unsigned)image.size());
+    return out.good() ? 0 : 1;
+}
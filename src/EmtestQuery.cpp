@@ -0,0 +1,399 @@
+// 无窗口的批量种子查询：逐行读取 json 查询，逐行输出 json 结果
+// 用法: emtest-query [--threads N] [input]，input 缺省或为 - 时读取标准输入
+// 需在包含 assets 目录的路径下运行
+//
+// 查询，约束之间为与关系，同一约束的多个取值之间为或关系:
+//   {"id": 1, "terrain": "Default", "limit": 10, "detail": true,
+//    "where": {"Nightlord": "Gladius", "Spawn Point": ["Lake", "Far Southwest"],
+//              "Major Base": {"Summonwater": "Fort - Crystalians", "*": "Camp - Redmane Knights"}}}
+//   标量字段取字符串或字符串数组，地点字段（Spawn Point 等）取地点名，null 表示空
+//   按地点取值的字段以地点名为键，"*" 表示任意地点
+// 结果:
+//   {"id": 1, "count": 2, "seeds": [12, 40], "details": [{"index": 12, ...}, ...]}
+//   没有种子满足全部约束时（观察有误或互相矛盾）附带最接近的种子，distance 为不满足的约束数，
+//   个数由查询的 "nearest" 指定，缺省为 NEAREST_COUNT，0 表示不返回:
+//   {"id": 1, "count": 0, "seeds": [], "nearest": [{"index": 12, "distance": 1}, ...]}
+//   出错时为 {"id": 1, "error": "..."}
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "AssetUtils.h"
+#include "LogUtils.h"
+#include "SeedQuery.h"
+#include "SeedSimilarity.h"
+#include "ThreadPool.h"
+
+using JsonBuffer = rapidjson::StringBuffer;
+using JsonWriter = rapidjson::Writer<JsonBuffer>;
+
+// 每批读取的查询行数，多线程时每批按行均分为线程数份
+static constexpr size_t BATCH_LINES = 16384;
+// 无匹配时缺省返回的最接近种子数
+static constexpr uint32_t NEAREST_COUNT = 5;
+// 未知地点名使用的 slot，超出任何地形的地点数：精确匹配为空，最接近的种子按不满足计入距离
+static constexpr uint16_t UNKNOWN_SLOT = SEED_ANY_SLOT - 1;
+
+// 每个线程独占的解析与输出缓冲，批与批之间复用
+struct QueryWorker {
+    rapidjson::MemoryPoolAllocator<> allocator;
+    SeedQuery query;
+    std::vector<SeedDistance> nearest;
+    JsonBuffer out;
+};
+
+class QueryEngine {
+public:
+    bool Initialize();
+    void Answer(const std::string& line, QueryWorker& worker) const;
+
+private:
+    struct Terrain {
+        MapThumbnail thumbnail;
+        SeedIndex index;
+        SeedSimilarity similarity;
+    };
+
+    const char* Parse(const rapidjson::Value& request, SeedQuery& query,
+        const Terrain*& terrain, bool& none) const;
+    bool Resolve(SeedField field, const rapidjson::Value& value,
+        std::vector<uint16_t>& values) const;
+    uint16_t FindString(const char* str) const;
+    uint16_t FindLocation(LocationType loc, const char* name) const;
+    void WriteDetail(const Terrain& terrain, const EmdbSeed& seed, JsonWriter& writer) const;
+
+private:
+    SeedDatabase m_Database;
+    std::vector<Terrain> m_Terrains;
+    std::unordered_map<std::string_view, const Terrain*> m_TerrainIds;
+    std::unordered_map<std::string_view, SeedField> m_FieldIds;
+    std::unordered_map<std::string_view, uint16_t> m_StringIds;
+    std::unordered_map<std::string_view, uint16_t> m_LocationIds[eLocationTypeCount];
+};
+
+bool QueryEngine::Initialize() {
+    Variables variables;
+    variables.Initialize();
+    if (!m_Database.Open("seeds.emdb")) {
+        LogInfo("Compile seed database from json\n");
+        if (!m_Database.Build(variables.GetTerrains()))
+            return false;
+    }
+
+    m_Terrains = std::vector<Terrain>(m_Database.TerrainCount());
+    for (uint32_t i = 0; i < m_Database.TerrainCount(); i++) {
+        const char* name = m_Database.String(m_Database.Terrain(i).name);
+        auto& terrain = m_Terrains[i];
+        terrain.thumbnail.LoadMap(m_Database, name);
+        terrain.index.Build(terrain.thumbnail);
+        terrain.similarity.Build(terrain.index);
+        m_TerrainIds.emplace(name, &terrain);
+    }
+
+    for (int f = 0; f < eSeedFieldCount; f++) {
+        m_FieldIds.emplace(GetSeedFieldInfo((SeedField)f).name, (SeedField)f);
+    }
+    for (uint32_t id = 0; id < m_Database.StringCount(); id++) {
+        m_StringIds.emplace(m_Database.String(id), (uint16_t)id);
+    }
+    for (int loc = 0; loc < eLocationTypeCount; loc++) {
+        auto type = (LocationType)loc;
+        for (uint16_t id = 0; id < m_Database.Type(type).count; id++) {
+            m_LocationIds[loc].emplace(m_Database.String(m_Database.Location(type, id).name), id);
+        }
+    }
+    return true;
+}
+
+uint16_t QueryEngine::FindString(const char* str) const {
+    auto itr = m_StringIds.find(str);
+    return itr == m_StringIds.end() ? EMDB_NO_LOCATION : itr->second;
+}
+
+uint16_t QueryEngine::FindLocation(LocationType loc, const char* name) const {
+    auto itr = m_LocationIds[loc].find(name);
+    return itr == m_LocationIds[loc].end() ? EMDB_NO_LOCATION : itr->second;
+}
+
+// 取值转为索引中的 id，未知的取值直接丢弃
+bool QueryEngine::Resolve(SeedField field, const rapidjson::Value& value,
+    std::vector<uint16_t>& values) const {
+    const auto& info = GetSeedFieldInfo(field);
+    bool byLocation = !IsPerLocation(field) && info.location != eLocationTypeCount;
+    auto resolve = [&](const rapidjson::Value& item) {
+        if (item.IsNull()) {
+            values.push_back(byLocation ? EMDB_NO_LOCATION : EMDB_EMPTY_STRING);
+            return true;
+        }
+        if (!item.IsString())
+            return false;
+        uint16_t id = byLocation
+            ? FindLocation(info.location, item.GetString())
+            : FindString(item.GetString());
+        if (id != EMDB_NO_LOCATION)
+            values.push_back(id);
+        return true;
+    };
+
+    if (!value.IsArray())
+        return resolve(value);
+    for (const auto& item : value.GetArray()) {
+        if (!resolve(item))
+            return false;
+    }
+    return true;
+}
+
+// 返回错误信息，约束中有不存在的取值或地点时 none 为 true
+const char* QueryEngine::Parse(const rapidjson::Value& request, SeedQuery& query,
+    const Terrain*& terrain, bool& none) const {
+    if (!request.IsObject())
+        return "query must be an object";
+
+    auto terrainItr = request.FindMember("terrain");
+    if (terrainItr == request.MemberEnd() || !terrainItr->value.IsString())
+        return "missing terrain";
+    auto found = m_TerrainIds.find(terrainItr->value.GetString());
+    if (found == m_TerrainIds.end())
+        return "unknown terrain";
+    terrain = found->second;
+
+    auto whereItr = request.FindMember("where");
+    if (whereItr == request.MemberEnd())
+        return nullptr;
+    if (!whereItr->value.IsObject())
+        return "where must be an object";
+
+    std::vector<uint16_t> values;
+    for (const auto& member : whereItr->value.GetObject()) {
+        auto fieldItr = m_FieldIds.find(member.name.GetString());
+        if (fieldItr == m_FieldIds.end())
+            return "unknown field";
+        SeedField field = fieldItr->second;
+
+        if (!IsPerLocation(field)) {
+            values.clear();
+            if (!Resolve(field, member.value, values))
+                return "values must be strings";
+            none = none || values.empty();
+            query.WhereAny(field, 0, values);
+            continue;
+        }
+
+        if (!member.value.IsObject())
+            return "per location field must be an object";
+        auto loc = GetSeedFieldInfo(field).location;
+        for (const auto& slotMember : member.value.GetObject()) {
+            const char* slotName = slotMember.name.GetString();
+            bool anySlot = strcmp(slotName, "*") == 0;
+            uint16_t slot = anySlot ? SEED_ANY_SLOT : FindLocation(loc, slotName);
+            // 未知地点不能沿用 EMDB_NO_LOCATION，它与 SEED_ANY_SLOT 相同，会被当成任意地点
+            bool unknown = !anySlot && slot == EMDB_NO_LOCATION;
+            if (unknown)
+                slot = UNKNOWN_SLOT;
+            values.clear();
+            if (!Resolve(field, slotMember.value, values))
+                return "values must be strings";
+            none = none || unknown || values.empty();
+            query.WhereAny(field, slot, values);
+        }
+    }
+    return nullptr;
+}
+
+void QueryEngine::WriteDetail(const Terrain& terrain, const EmdbSeed& seed, JsonWriter& writer) const {
+    const auto& thumbnail = terrain.thumbnail;
+    writer.StartObject();
+    writer.Key("index");
+    writer.Uint(seed.index);
+    for (int f = 0; f < eSeedFieldCount; f++) {
+        auto field = (SeedField)f;
+        const auto& info = GetSeedFieldInfo(field);
+        writer.Key(info.name);
+        if (!IsPerLocation(field)) {
+            uint16_t value = seed.*info.member;
+            if (info.location != eLocationTypeCount)
+                writer.String(thumbnail.Name(info.location, value));
+            else
+                writer.String(thumbnail.String(value));
+            continue;
+        }
+
+        writer.StartObject();
+        for (uint16_t slot = 0; slot < thumbnail.LocationCount(info.location); slot++) {
+            uint16_t value = thumbnail.ValueOf(seed, info.location, slot);
+            if (!thumbnail.Query(info.location, slot) || value == EMDB_EMPTY_STRING)
+                continue;
+            writer.Key(thumbnail.Name(info.location, slot));
+            writer.String(thumbnail.String(value));
+        }
+        writer.EndObject();
+    }
+    writer.EndObject();
+}
+
+void QueryEngine::Answer(const std::string& line, QueryWorker& worker) const {
+    JsonWriter writer(worker.out);
+    rapidjson::Document request(&worker.allocator);
+    request.Parse(line.data(), line.size());
+
+    writer.StartObject();
+    if (request.IsObject()) {
+        auto idItr = request.FindMember("id");
+        if (idItr != request.MemberEnd()) {
+            writer.Key("id");
+            idItr->value.Accept(writer);
+        }
+    }
+
+    const Terrain* terrain = nullptr;
+    bool none = false;
+    worker.query.Clear();
+    const char* error = request.HasParseError()
+        ? "invalid json" : Parse(request, worker.query, terrain, none);
+    if (error) {
+        writer.Key("error");
+        writer.String(error);
+    }
+    else {
+        uint32_t limit = UINT32_MAX;
+        bool detail = false;
+        auto limitItr = request.FindMember("limit");
+        if (limitItr != request.MemberEnd() && limitItr->value.IsUint())
+            limit = limitItr->value.GetUint();
+        auto detailItr = request.FindMember("detail");
+        if (detailItr != request.MemberEnd() && detailItr->value.IsBool())
+            detail = detailItr->value.GetBool();
+        uint32_t nearest = NEAREST_COUNT;
+        auto nearestItr = request.FindMember("nearest");
+        if (nearestItr != request.MemberEnd() && nearestItr->value.IsUint())
+            nearest = nearestItr->value.GetUint();
+
+        SeedBitset candidates = none
+            ? SeedBitset(terrain->index.SeedCount()) : worker.query.Match(terrain->index);
+        uint32_t count = candidates.Count();
+        writer.Key("count");
+        writer.Uint(count);
+
+        uint32_t written = 0;
+        writer.Key("seeds");
+        writer.StartArray();
+        candidates.Foreach([&](uint32_t i) {
+            if (written++ < limit)
+                writer.Uint(terrain->thumbnail.Seed(i).index);
+        });
+        writer.EndArray();
+
+        if (detail) {
+            written = 0;
+            writer.Key("details");
+            writer.StartArray();
+            candidates.Foreach([&](uint32_t i) {
+                if (written++ < limit)
+                    WriteDetail(*terrain, terrain->thumbnail.Seed(i), writer);
+            });
+            writer.EndArray();
+        }
+
+        if (count == 0 && nearest > 0 && !worker.query.Empty()) {
+            terrain->similarity.Nearest(worker.query, nearest, worker.nearest);
+            writer.Key("nearest");
+            writer.StartArray();
+            for (const auto& near : worker.nearest) {
+                writer.StartObject();
+                writer.Key("index");
+                writer.Uint(terrain->thumbnail.Seed(near.seed).index);
+                writer.Key("distance");
+                writer.Uint(near.distance);
+                writer.EndObject();
+            }
+            writer.EndArray();
+        }
+    }
+    writer.EndObject();
+    worker.out.Put('\n');
+    worker.allocator.Clear();
+}
+
+static bool ReadBatch(std::istream& in, std::vector<std::string>& lines) {
+    size_t count = 0;
+    while (count < BATCH_LINES) {
+        if (count == lines.size())
+            lines.emplace_back();
+        if (!std::getline(in, lines[count]))
+            break;
+        if (!lines[count].empty() && lines[count].back() == '\r')
+            lines[count].pop_back();
+        if (!lines[count].empty())
+            count++;
+    }
+    lines.resize(count);
+    return count > 0;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 1;
+    const char* input = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads <= 0)
+                threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (strcmp(argv[i], "-") != 0) {
+            input = argv[i];
+        }
+    }
+
+    QueryEngine engine;
+    if (!engine.Initialize()) {
+        LogInfo("Failed to load seed database\n");
+        return 1;
+    }
+
+    std::ifstream file;
+    if (input) {
+        file.open(input);
+        if (!file.is_open()) {
+            LogInfo("Could not open the file %s\n", input);
+            return 1;
+        }
+    }
+    std::istream& in = input ? file : std::cin;
+    std::ios::sync_with_stdio(false);
+
+    // 工作线程在进程内只创建一次，各批复用；单线程时不启动，批在主线程中执行
+    ThreadPool pool;
+    if (threads > 1)
+        pool.Start(threads - 1);
+    std::vector<QueryWorker> workers(threads);
+    std::vector<std::string> lines;
+    while (ReadBatch(in, lines)) {
+        // 每份为连续的一段行并使用各自的 worker，按份的顺序输出以保持与输入相同的顺序
+        size_t share = (lines.size() + threads - 1) / threads;
+        pool.ParallelFor((uint32_t)threads, [&engine, &lines, &workers, share](uint32_t t) {
+            size_t first = std::min(lines.size(), t * share);
+            size_t last = std::min(lines.size(), first + share);
+            for (size_t i = first; i < last; i++) {
+                engine.Answer(lines[i], workers[t]);
+            }
+        });
+
+        for (auto& worker : workers) {
+            fwrite(worker.out.GetString(), 1, worker.out.GetSize(), stdout);
+            worker.out.Clear();
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,51 @@
+// 离线把 png 转为可直接上传的纹理（预乘 alpha 的 RGBA8）：
+// .emtex 含完整 mip 链；--tiles 时生成 .emtiles 瓦片金字塔，供地图按缩放流式加载
+// 用法: emtex_compile [--tiles <size>] <input.png> <output>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "stb_image.h"
+
+#include "LogUtils.h"
+#include "TextureFile.h"
+
+int main(int argc, char* argv[]) {
+    uint32_t tileSize = 0;
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "--tiles") == 0) {
+        tileSize = (uint32_t)atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 2) {
+        LogInfo("usage: emtex_compile [--tiles <size>] <input.png> <output>\n");
+        return 1;
+    }
+    const char* input = argv[arg];
+    const char* output = argv[arg + 1];
+
+    // 与 LoadTexture 相同，行翻转为 GL 纹理坐标的自下而上
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(input, &width, &height, &channels, 4);
+    if (!pixels) {
+        LogInfo("Failed to load texture: %s\n", input);
+        return 1;
+    }
+
+    std::vector<char> image;
+    if (tileSize > 0)
+        TileFile::Compile(pixels, width, height, tileSize, image);
+    else
+        TextureFile::Compile(pixels, width, height, image);
+    stbi_image_free(pixels);
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LogInfo("Could not open the file %s\n", output);
+        return 1;
+    }
+    out.write(image.data(), image.size());
+    LogInfo("Compile Texture %s (%dx%d, %u bytes)\n", output, width, height, (unsigned)image.size());
+    return out.good() ? 0 : 1;
+}
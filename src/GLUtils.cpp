@@ -3,6 +3,8 @@
 #include <SDL_log.h>
 #include <fstream>
 
+#include "Profiler.h"
+
 GLuint CompileShader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, nullptr);
@@ -36,17 +38,71 @@ GLuint CompileShaderFile(GLenum type, const char* path) {
     return CompileShader(type, source.c_str());
 }
 
-GLuint LoadTexture(const char* path, int& width, int& height, bool flip) {
-    stbi_set_flip_vertically_on_load(flip);
+bool ShaderProgram::Load(const char* vsPath, const char* fsPath) {
+    Cleanup();
+    GLuint vs = CompileShaderFile(GL_VERTEX_SHADER, vsPath);
+    GLuint fs = CompileShaderFile(GL_FRAGMENT_SHADER, fsPath);
 
-    int nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (!data) {
-        SDL_Log("Failed to load texture: %s", path);
-        return 0;
+    m_Program = glCreateProgram();
+    glAttachShader(m_Program, vs);
+    glAttachShader(m_Program, fs);
+    glLinkProgram(m_Program);
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint success;
+    glGetProgramiv(m_Program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(m_Program, 512, nullptr, infoLog);
+        SDL_Log("Program link error: %s\n", infoLog);
+        return false;
     }
-    SDL_Log("Load Texture %s (%dx%d)", path, height, width);
 
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(m_Program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(maxLength, '\0');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_Program, i, maxLength, &length, &size, &type, name.data());
+        std::string key(name.data(), length);
+        GLint location = glGetUniformLocation(m_Program, key.c_str());
+        // block 内的成员没有位置
+        if (location < 0)
+            continue;
+        // 数组以 name[0] 返回，同时登记不带下标的名字
+        auto bracket = key.find('[');
+        if (bracket != std::string::npos)
+            m_Uniforms.emplace(key.substr(0, bracket), location);
+        m_Uniforms.emplace(std::move(key), location);
+    }
+    return true;
+}
+
+void ShaderProgram::Cleanup() {
+    if (m_Program != 0)
+        glDeleteProgram(m_Program);
+    m_Program = 0;
+    m_Uniforms.clear();
+}
+
+GLint ShaderProgram::Uniform(const char* name) const {
+    auto itr = m_Uniforms.find(name);
+    return itr == m_Uniforms.end() ? -1 : itr->second;
+}
+
+void ShaderProgram::BindBlock(const char* name, GLuint binding) const {
+    GLuint index = glGetUniformBlockIndex(m_Program, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_Program, index, binding);
+}
+
+// 创建纹理并上传像素，data 为空时从当前绑定的 GL_PIXEL_UNPACK_BUFFER 读取
+static GLuint CreateTexture(const unsigned char* data, int width, int height, int channels) {
     GLuint texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
@@ -56,10 +112,271 @@ GLuint LoadTexture(const char* path, int& width, int& height, bool flip) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
+    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    return texture;
+}
+
+// 从 .emtex 上传全部 mip 层级，像素直接取自映射的文件
+static GLuint CreateTexture(const TextureFile& file) {
+    const auto& header = file.Header();
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levelCount - 1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        const auto& level = header.levels[i];
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level.width, level.height, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, file.Level(i));
+    }
+    return texture;
+}
+
+// 同名 .emtex 的路径，如 assets/textures/bg.png -> assets/textures/bg.emtex
+static std::string EmtexPath(const char* path) {
+    std::string result(path);
+    auto dot = result.find_last_of('.');
+    if (dot != std::string::npos)
+        result.erase(dot);
+    return result + ".emtex";
+}
+
+// .emtex 的行已按 GL 自下而上存放，只用于需要翻转的加载
+static bool OpenTextureFile(TextureFile& file, const char* path, bool flip) {
+    return flip && file.Open(EmtexPath(path).c_str());
+}
+
+GLuint LoadTexture(const char* path, int& width, int& height, bool flip) {
+    PROFILE_SCOPE("LoadTexture");
+    TextureFile file;
+    if (OpenTextureFile(file, path, flip)) {
+        width = file.Header().width;
+        height = file.Header().height;
+        SDL_Log("Load Texture %s (%dx%d)", EmtexPath(path).c_str(), height, width);
+        return CreateTexture(file);
+    }
+
+    stbi_set_flip_vertically_on_load_thread(flip);
+
+    int nrChannels;
+    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (!data) {
+        SDL_Log("Failed to load texture: %s", path);
+        return 0;
+    }
+    SDL_Log("Load Texture %s (%dx%d)", path, height, width);
+
+    // 与 .emtex 一致，纹理统一为预乘 alpha
+    if (nrChannels == 4)
+        TextureFile::Premultiply(data, (size_t)width * height);
+    GLuint texture = CreateTexture(data, width, height, nrChannels);
 
     stbi_image_free(data);
 
     return texture;
-}
\ No newline at end of file
+}
+
+TextureLoader::~TextureLoader() {
+    Cleanup();
+}
+
+void TextureLoader::Initialize(Notify&& notify) {
+    m_Notify = notify;
+    glGenBuffers(1, &m_UnpackBuffer);
+#ifdef TEXTURE_LOADER_THREAD
+    m_Quit = false;
+    m_Worker = std::thread(&TextureLoader::WorkerMain, this);
+#endif
+}
+
+void TextureLoader::Cleanup() {
+#ifdef TEXTURE_LOADER_THREAD
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Wake.notify_all();
+    if (m_Worker.joinable())
+        m_Worker.join();
+#endif
+    for (auto& job : m_Done) {
+        stbi_image_free(job.pixels);
+    }
+    m_Pending.clear();
+    m_Done.clear();
+    if (m_UnpackBuffer != 0)
+        glDeleteBuffers(1, &m_UnpackBuffer);
+    m_UnpackBuffer = 0;
+}
+
+void TextureLoader::Load(const char* path, bool flip, Callback&& callback) {
+    Job job;
+    job.path = path;
+    job.flip = flip;
+    job.callback = std::move(callback);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Pending.push_back(std::move(job));
+    }
+#ifdef TEXTURE_LOADER_THREAD
+    m_Wake.notify_one();
+#endif
+}
+
+void TextureLoader::Decode(Job& job) {
+    PROFILE_SCOPE("DecodeTexture");
+    auto file = std::make_unique<TextureFile>();
+    if (OpenTextureFile(*file, job.path.c_str(), job.flip)) {
+        job.width = file->Header().width;
+        job.height = file->Header().height;
+        // 在工作线程中预先触发缺页，上传时不再等待磁盘
+        volatile unsigned char sink = 0;
+        const unsigned char* data = file->Level(0);
+        for (uint32_t offset = 0; offset < file->Header().size - sizeof(EmtexHeader); offset += 4096) {
+            sink = sink + data[offset];
+        }
+        job.file = std::move(file);
+        return;
+    }
+
+    stbi_set_flip_vertically_on_load_thread(job.flip);
+    job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.channels, 0);
+    if (!job.pixels) {
+        SDL_Log("Failed to load texture: %s", job.path.c_str());
+        return;
+    }
+    if (job.channels == 4)
+        TextureFile::Premultiply(job.pixels, (size_t)job.width * job.height);
+}
+
+#ifdef TEXTURE_LOADER_THREAD
+void TextureLoader::WorkerMain() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this] { return m_Quit || !m_Pending.empty(); });
+            if (m_Quit)
+                return;
+            job = std::move(m_Pending.front());
+            m_Pending.pop_front();
+        }
+        Decode(job);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Done.push_back(std::move(job));
+        }
+        if (m_Notify)
+            m_Notify();
+    }
+}
+#endif
+
+void TextureLoader::Poll() {
+#ifndef TEXTURE_LOADER_THREAD
+    // 没有工作线程时延后一帧再解码，发起请求的那一帧不被阻塞
+    if (!m_Pending.empty()) {
+        if (m_Deferred) {
+            Decode(m_Pending.front());
+            m_Done.push_back(std::move(m_Pending.front()));
+            m_Pending.pop_front();
+        }
+        m_Deferred = !m_Deferred;
+        if (m_Notify)
+            m_Notify();
+    }
+#endif
+
+    std::deque<Job> done;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        done.swap(m_Done);
+    }
+    for (auto& job : done) {
+        GLuint texture = 0;
+        if (job.file) {
+            PROFILE_SCOPE("UploadTexture");
+            SDL_Log("Load Texture %s (%dx%d)", EmtexPath(job.path.c_str()).c_str(), job.height, job.width);
+            texture = CreateTexture(*job.file);
+            job.file.reset();
+        }
+        else if (job.pixels) {
+            PROFILE_SCOPE("UploadTexture");
+            SDL_Log("Load Texture %s (%dx%d)", job.path.c_str(), job.height, job.width);
+            size_t size = (size_t)job.width * job.height * job.channels;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_UnpackBuffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, job.pixels, GL_STREAM_DRAW);
+            texture = CreateTexture(nullptr, job.width, job.height, job.channels);
+            // 释放缓冲的存储，驱动在上传完成后回收
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            stbi_image_free(job.pixels);
+            job.pixels = nullptr;
+        }
+        if (job.callback)
+            job.callback(texture, job.width, job.height);
+    }
+}
+
+void GpuTimer::Initialize() {
+#ifdef WIN32
+    m_Supported = GLAD_GL_VERSION_3_3 != 0;
+#endif
+    if (m_Supported)
+        glGenQueries(QUERY_COUNT, m_Queries);
+}
+
+void GpuTimer::Cleanup() {
+    if (m_Supported)
+        glDeleteQueries(QUERY_COUNT, m_Queries);
+    m_Supported = false;
+    m_Issued = 0;
+    m_Read = 0;
+}
+
+void GpuTimer::Begin() {
+#ifdef GL_TIME_ELAPSED
+    if (!m_Supported || m_Issued - m_Read >= QUERY_COUNT)
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Issued % QUERY_COUNT]);
+    m_Active = true;
+#endif
+}
+
+void GpuTimer::End() {
+#ifdef GL_TIME_ELAPSED
+    if (!m_Active)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    m_Active = false;
+    m_Issued++;
+#endif
+}
+
+float GpuTimer::Poll() {
+    float result = -1;
+#ifdef GL_TIME_ELAPSED
+    // 只读取已完成的查询，不等待 GPU
+    while (m_Read < m_Issued) {
+        GLuint query = m_Queries[m_Read % QUERY_COUNT];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        result = elapsed / 1000000.f;
+        m_Read++;
+    }
+#endif
+    return result;
+}
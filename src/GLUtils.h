@@ -6,11 +6,114 @@
 #include <GLES3/gl3.h>
 #endif
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "TextureFile.h"
+
 GLuint CompileShader(GLenum type, const char* source);
 GLuint CompileShaderFile(GLenum type, const char* path);
+// 纹理统一为预乘 alpha；需要翻转时优先读取同名的 .emtex，缺失时解码 png
 GLuint LoadTexture(const char* path, int& width, int& height, bool flip);
+
+// 未启用 pthread 的 Emscripten 构建没有工作线程，解码退回到主线程
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define TEXTURE_LOADER_THREAD
+#endif
+
+// 异步纹理加载：工作线程解码图片，渲染线程在 Poll 中经 GL_PIXEL_UNPACK_BUFFER 上传
+class TextureLoader {
+public:
+    // 在渲染线程回调，失败时 texture 为 0
+    using Callback = std::function<void(GLuint texture, int width, int height)>;
+    // 在工作线程回调，通知有纹理等待上传
+    using Notify = std::function<void()>;
+
+    ~TextureLoader();
+    void Initialize(Notify&& notify);
+    void Cleanup();
+    void Load(const char* path, bool flip, Callback&& callback);
+    // 渲染线程每帧调用，上传已解码的图片并执行回调
+    void Poll();
+
+private:
+    struct Job {
+        std::string path;
+        bool flip = false;
+        Callback callback;
+        std::unique_ptr<TextureFile> file; // 已映射的 .emtex
+        unsigned char* pixels = nullptr;   // 解码的 png
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+    };
+
+    static void Decode(Job& job);
+    void WorkerMain();
+
+private:
+    Notify m_Notify;
+    GLuint m_UnpackBuffer = 0;
+    std::mutex m_Mutex;
+    std::deque<Job> m_Pending;
+    std::deque<Job> m_Done;
+#ifdef TEXTURE_LOADER_THREAD
+    std::thread m_Worker;
+    std::condition_variable m_Wake;
+    bool m_Quit = false;
+#else
+    bool m_Deferred = false;
+#endif
+};
+
+// 着色器程序，链接后一次性查询全部 uniform 位置，绘制时不再按名字查找
+class ShaderProgram {
+public:
+    bool Load(const char* vsPath, const char* fsPath);
+    void Cleanup();
+    void Use() const {
+        glUseProgram(m_Program);
+    }
+    GLuint Id() const {
+        return m_Program;
+    }
+    // 不存在或被优化掉的 uniform 返回 -1
+    GLint Uniform(const char* name) const;
+    // 将 uniform block 绑定到 binding 处，不存在时忽略
+    void BindBlock(const char* name, GLuint binding) const;
+
+private:
+    GLuint m_Program = 0;
+    std::unordered_map<std::string, GLint> m_Uniforms;
+};
+
+// GL 计时查询，结果延迟数帧读取以免等待 GPU
+// 需要 GL 3.3；WebGL2 的计时扩展不在核心中，Emscripten 构建下为空操作
+class GpuTimer {
+public:
+    void Initialize();
+    void Cleanup();
+    void Begin();
+    void End();
+    // 最近完成的一次耗时（毫秒），没有新结果时返回负数
+    float Poll();
+
+private:
+    static constexpr int QUERY_COUNT = 4;
+    GLuint m_Queries[QUERY_COUNT]{};
+    bool m_Supported = false;
+    bool m_Active = false;
+    uint32_t m_Issued = 0;
+    uint32_t m_Read = 0;
+};
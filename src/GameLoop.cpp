@@ -1,6 +1,14 @@
 #include "GameLoop.h"
+#include <algorithm>
 #include <iostream>
 
+#include "Profiler.h"
+
+// 输入后连续绘制的帧数，留给 ImGui 的悬停、展开等动画
+static constexpr int REDRAW_BURST = 10;
+// 空闲时单次等待事件的最长时间
+static constexpr int IDLE_WAIT_MS = 500;
+
 GameLoop::~GameLoop() {
     Cleanup();
 }
@@ -13,6 +21,7 @@ void GameLoop::Run() {
 
     m_Running = true;
     m_LastFrameTime = SDL_GetTicks();
+    RequestRedraw(REDRAW_BURST);
 
     // 平台特定的运行方式
 #ifdef __EMSCRIPTEN__
@@ -50,6 +59,9 @@ void GameLoop::MainLoop() {
         return;
     }
 
+    if (m_OnDemand)
+        WaitForChange();
+
     // 计算帧时间
     Uint32 currentTime = SDL_GetTicks();
     float deltaTime = (currentTime - m_LastFrameTime) / 1000.0f;
@@ -61,9 +73,22 @@ void GameLoop::MainLoop() {
     }
 
     // 游戏逻辑执行
-    ProcessInput();
-    Update(deltaTime);
-    Render();
+    {
+        PROFILE_SCOPE("ProcessInput");
+        ProcessInput();
+    }
+    {
+        PROFILE_SCOPE("Update");
+        Update(deltaTime);
+    }
+    if (m_OnDemand && m_RedrawFrames == 0)
+        return;
+    {
+        PROFILE_SCOPE("Render");
+        Render();
+    }
+    m_RedrawFrames = std::max(0, m_RedrawFrames - 1);
+    Profiler::Get().EndFrame();
 
     // 帧率控制（仅原生平台需要）
 #ifndef __EMSCRIPTEN__
@@ -77,6 +102,27 @@ void GameLoop::MainLoop() {
 #endif
 }
 
+void GameLoop::WaitForChange() {
+#ifndef __EMSCRIPTEN__
+    // 浏览器回调中不能阻塞，只跳过没有变化的帧
+    if (m_RedrawFrames == 0 && !IsRedrawPending())
+        SDL_WaitEventTimeout(nullptr, IDLE_WAIT_MS);
+#endif
+    SDL_PumpEvents();
+    if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT))
+        RequestRedraw(REDRAW_BURST);
+}
+
+void GameLoop::RequestRedraw(int frames) {
+    m_RedrawFrames = std::max(m_RedrawFrames, frames);
+}
+
+void GameLoop::PostRedraw() {
+    SDL_Event event{};
+    event.type = SDL_USEREVENT;
+    SDL_PushEvent(&event);
+}
+
 void GameLoop::Stop() {
     m_Running = false;
 }
@@ -87,6 +133,7 @@ void GameLoop::Pause() {
 
 void GameLoop::Resume() {
     m_Paused = false;
+    RequestRedraw();
     m_LastFrameTime = SDL_GetTicks(); // 重置时间避免大的deltaTime
 }
 
@@ -19,19 +19,33 @@ public:
     void SetTargetFPS(int fps) { m_TargetFPS = fps; }
     int GetTargetFPS() const { return m_TargetFPS; }
 
+    // 按需渲染：空闲时阻塞等待事件，只在有变化时重绘
+    void SetOnDemand(bool value) { m_OnDemand = value; }
+    bool IsOnDemand() const { return m_OnDemand; }
+    // 请求至少再绘制 frames 帧
+    void RequestRedraw(int frames = 1);
+    // 可在任意线程调用，唤醒等待中的主循环并重绘，用于异步任务完成
+    static void PostRedraw();
+
 protected:
     virtual void Initialize() = 0;
     virtual void ProcessInput() = 0;
     virtual void Update(float deltaTime) = 0;
     virtual void Render() = 0;
     virtual void Cleanup();
+    // 渲染中产生、尚未绘制的变化（如仍有瓦片待上传），为 true 时不阻塞等待事件
+    virtual bool IsRedrawPending() const { return false; }
 
 private:
     void MainLoop();
+    void WaitForChange();
     static void MainLoopWrapper(void* userData);
 
     bool m_Running = false;
     bool m_Paused = false;
     int m_TargetFPS = 30;
     Uint32 m_LastFrameTime = 0;
+
+    bool m_OnDemand = false;
+    int m_RedrawFrames = 0;
 };
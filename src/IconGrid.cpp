@@ -0,0 +1,42 @@
+#include "IconGrid.h"
+#include <algorithm>
+#include <cmath>
+
+void IconGrid::Reset(const glm::vec2& size, float cellSize) {
+    m_CellSize = cellSize;
+    m_Columns = std::max(1, (int)std::ceil(size.x / cellSize));
+    m_Rows = std::max(1, (int)std::ceil(size.y / cellSize));
+    m_Cells.assign((size_t)m_Columns * m_Rows, {});
+}
+
+void IconGrid::Clear() {
+    for (auto& cell : m_Cells) {
+        cell.clear();
+    }
+}
+
+void IconGrid::Insert(uint32_t id, const glm::vec2& pos) {
+    if (m_Cells.empty())
+        return;
+    glm::ivec2 cell = Cell(pos);
+    m_Cells[cell.y * m_Columns + cell.x].push_back(id);
+}
+
+void IconGrid::Remove(uint32_t id, const glm::vec2& pos) {
+    if (m_Cells.empty())
+        return;
+    glm::ivec2 cell = Cell(pos);
+    auto& ids = m_Cells[cell.y * m_Columns + cell.x];
+    auto itr = std::find(ids.begin(), ids.end(), id);
+    if (itr != ids.end()) {
+        *itr = ids.back();
+        ids.pop_back();
+    }
+}
+
+glm::ivec2 IconGrid::Cell(const glm::vec2& pos) const {
+    // 先在浮点范围内截断再转整数，超出 int 范围的坐标（如 FLT_MAX）转换是未定义行为；fmin 同时把 NaN 归到边界
+    float x = std::fmax(0.f, std::fmin(std::floor(pos.x / m_CellSize), float(m_Columns - 1)));
+    float y = std::fmax(0.f, std::fmin(std::floor(pos.y / m_CellSize), float(m_Rows - 1)));
+    return glm::ivec2((int)x, (int)y);
+}
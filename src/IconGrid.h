@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// 图标位置的均匀网格，坐标为地图像素（原点在左上角），按中心所在的格子分桶。
+// 地图外的位置归入边缘的格子；同一格内的 id 无序
+class IconGrid {
+public:
+    void Reset(const glm::vec2& size, float cellSize);
+    void Clear();
+    void Insert(uint32_t id, const glm::vec2& pos);
+    // pos 须与插入时相同
+    void Remove(uint32_t id, const glm::vec2& pos);
+
+    // 遍历中心可能落在 [min, max] 内的 id，结果包含同格中范围外的元素，由调用方精确判断
+    template<class Func>
+    void Query(const glm::vec2& min, const glm::vec2& max, Func&& func) const {
+        if (m_Cells.empty())
+            return;
+        glm::ivec2 c0 = Cell(min);
+        glm::ivec2 c1 = Cell(max);
+        for (int y = c0.y; y <= c1.y; y++) {
+            for (int x = c0.x; x <= c1.x; x++) {
+                for (uint32_t id : m_Cells[y * m_Columns + x]) {
+                    func(id);
+                }
+            }
+        }
+    }
+
+private:
+    glm::ivec2 Cell(const glm::vec2& pos) const;
+
+private:
+    float m_CellSize = 1;
+    int m_Columns = 0;
+    int m_Rows = 0;
+    std::vector<std::vector<uint32_t>> m_Cells;
+};
@@ -0,0 +1,65 @@
+#include "IconStore.h"
+
+IconHandle IconStore::Add(const glm::vec2& pos, IconKind kind, int layer, float scale, uint32_t userdata) {
+    uint32_t slot;
+    if (!m_FreeSlots.empty()) {
+        slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else {
+        slot = Capacity();
+        m_Pos.emplace_back();
+        m_Scale.emplace_back();
+        m_LayerMask.emplace_back();
+        m_Kind.emplace_back();
+        m_UserData.emplace_back();
+        m_Generation.emplace_back();
+        m_Sequence.emplace_back();
+        m_LayerIndex.emplace_back();
+    }
+
+    m_Pos[slot] = pos;
+    m_Scale[slot] = scale;
+    m_LayerMask[slot] = 1u << layer;
+    m_Kind[slot] = (uint8_t)kind;
+    m_UserData[slot] = userdata;
+    m_Sequence[slot] = m_NextSequence++;
+    m_LayerIndex[slot] = (uint32_t)m_Layers[layer].size();
+    m_Layers[layer].push_back(slot);
+    return Handle(slot);
+}
+
+void IconStore::Remove(IconHandle handle) {
+    if (!IsValid(handle))
+        return;
+    uint32_t slot = Slot(handle);
+
+    // 从所属层的列表中交换删除
+    auto& slots = m_Layers[LayerOf(m_LayerMask[slot])];
+    uint32_t last = slots.back();
+    slots[m_LayerIndex[slot]] = last;
+    m_LayerIndex[last] = m_LayerIndex[slot];
+    slots.pop_back();
+
+    Free(slot);
+}
+
+void IconStore::RemoveLayer(int layer) {
+    for (uint32_t slot : m_Layers[layer]) {
+        Free(slot);
+    }
+    m_Layers[layer].clear();
+}
+
+void IconStore::Clear() {
+    for (int layer = 0; layer < MAX_LAYERS; layer++) {
+        RemoveLayer(layer);
+    }
+    m_NextSequence = 0;
+}
+
+void IconStore::Free(uint32_t slot) {
+    m_LayerMask[slot] = 0;
+    m_Generation[slot]++;
+    m_FreeSlots.push_back(slot);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AssetUtils.h"
+
+// 图标句柄：低 24 位为槽位，高 8 位为槽位的代数，槽位删除后旧句柄失效
+using IconHandle = uint32_t;
+constexpr IconHandle INVALID_ICON = 0xFFFFFFFF;
+
+// 地图图标的结构数组存储：位置、缩放、显示层掩码、图标种类等按槽位分列存放。
+// 删除的槽位进入空闲列表复用，容量达到峰值后增删不再分配内存；
+// 每层维护各自的槽位列表，按层删除只访问该层的图标。空闲槽位的层掩码为 0
+class IconStore {
+public:
+    static constexpr int MAX_LAYERS = 32;
+
+    IconHandle Add(const glm::vec2& pos, IconKind kind, int layer, float scale, uint32_t userdata);
+    void Remove(IconHandle handle);
+    void RemoveLayer(int layer);
+    void Clear();
+    bool IsValid(IconHandle handle) const {
+        uint32_t slot = Slot(handle);
+        return slot < Capacity() && m_LayerMask[slot] != 0 && Handle(slot) == handle;
+    }
+    void SetScale(IconHandle handle, float scale) {
+        if (IsValid(handle))
+            m_Scale[Slot(handle)] = scale;
+    }
+
+    // 遍历 layer 层的全部槽位，遍历期间不可增删
+    template<class Func>
+    void ForeachInLayer(int layer, Func&& func) const {
+        for (uint32_t slot : m_Layers[layer]) {
+            func(slot);
+        }
+    }
+    uint32_t LayerCount(int layer) const {
+        return (uint32_t)m_Layers[layer].size();
+    }
+
+    // 槽位总数（含空闲槽位）
+    uint32_t Capacity() const {
+        return (uint32_t)m_Pos.size();
+    }
+    // 层掩码对应的层号
+    static int LayerOf(uint32_t mask) {
+        int layer = 0;
+        while ((mask >> layer) > 1)
+            layer++;
+        return layer;
+    }
+    static uint32_t Slot(IconHandle handle) {
+        return handle & 0xFFFFFF;
+    }
+    IconHandle Handle(uint32_t slot) const {
+        return slot | (uint32_t)m_Generation[slot] << 24;
+    }
+    const glm::vec2& Pos(uint32_t slot) const {
+        return m_Pos[slot];
+    }
+    float Scale(uint32_t slot) const {
+        return m_Scale[slot];
+    }
+    uint32_t LayerMask(uint32_t slot) const {
+        return m_LayerMask[slot];
+    }
+    IconKind Kind(uint32_t slot) const {
+        return (IconKind)m_Kind[slot];
+    }
+    uint32_t UserData(uint32_t slot) const {
+        return m_UserData[slot];
+    }
+    // 添加时的序号，越大越晚添加；槽位复用时重新取号
+    uint32_t Sequence(uint32_t slot) const {
+        return m_Sequence[slot];
+    }
+    const std::vector<float>& Scales() const {
+        return m_Scale;
+    }
+    const std::vector<uint8_t>& Kinds() const {
+        return m_Kind;
+    }
+    const std::vector<uint32_t>& LayerMasks() const {
+        return m_LayerMask;
+    }
+
+private:
+    void Free(uint32_t slot);
+
+private:
+    std::vector<glm::vec2> m_Pos;
+    std::vector<float> m_Scale;
+    std::vector<uint32_t> m_LayerMask;
+    std::vector<uint8_t> m_Kind;
+    std::vector<uint32_t> m_UserData;
+    std::vector<uint8_t> m_Generation;
+    std::vector<uint32_t> m_Sequence;
+    uint32_t m_NextSequence = 0;
+    // 槽位在所属层列表中的下标，删除时与末尾交换
+    std::vector<uint32_t> m_LayerIndex;
+
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<uint32_t> m_Layers[MAX_LAYERS];
+};
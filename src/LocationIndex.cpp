@@ -0,0 +1,119 @@
+#include "LocationIndex.h"
+#include <algorithm>
+
+#include "Profiler.h"
+
+void LocationIndex::Build(const SeedDatabase& database, const EmdbTerrain& terrain) {
+    Clear();
+
+    for (int t = 0; t < eLocationTypeCount; t++) {
+        auto type = (LocationType)t;
+        uint32_t count = database.Type(type).count;
+        m_TypeCounts[t] = count;
+        m_TreeFirst[t] = (uint32_t)m_Nodes.size();
+        for (uint32_t id = 0; id < count && id < 32; id++) {
+            if (terrain.present[t] & (1u << id))
+                m_Nodes.push_back({ glm::vec2(database.Location(type, (uint16_t)id).pos), (uint16_t)id });
+        }
+        BuildTree(m_Nodes, m_TreeFirst[t], m_Nodes.size(), 0);
+    }
+    m_TreeFirst[eLocationTypeCount] = (uint32_t)m_Nodes.size();
+}
+
+void LocationIndex::Clear() {
+    m_Nodes.clear();
+    std::fill(std::begin(m_TreeFirst), std::end(m_TreeFirst), 0);
+    // 保留近邻表的容量，下次载入地形时直接复用
+    for (auto& pairs : m_Pairs) {
+        for (auto& pair : pairs) {
+            pair.built = false;
+        }
+    }
+    std::fill(std::begin(m_TypeCounts), std::end(m_TypeCounts), 0);
+}
+
+void LocationIndex::BuildPair(LocationType from, LocationType to, PairTable& pair) const {
+    PROFILE_SCOPE("LocationIndex::BuildPair");
+    uint32_t rows = m_TypeCounts[from];
+    pair.neighbors.assign((size_t)rows * NEAREST_K, {});
+    pair.counts.assign(rows, 0);
+    for (uint32_t i = m_TreeFirst[from]; i < m_TreeFirst[from + 1]; i++) {
+        const auto& node = m_Nodes[i];
+        // 同类时多取一个，去掉自身
+        Nearest(node.pos, to, NEAREST_K + 1, m_Result);
+        uint8_t count = 0;
+        for (const auto& neighbor : m_Result) {
+            if (from == to && neighbor.id == node.id)
+                continue;
+            if (count == NEAREST_K)
+                break;
+            pair.neighbors[(size_t)node.id * NEAREST_K + count++] = neighbor;
+        }
+        pair.counts[node.id] = count;
+    }
+    pair.built = true;
+}
+
+LocationNeighbors LocationIndex::Nearest(LocationType from, uint16_t id, LocationType to) const {
+    if (id >= m_TypeCounts[from])
+        return {};
+    auto& pair = m_Pairs[from][to];
+    if (!pair.built)
+        BuildPair(from, to, pair);
+    return { &pair.neighbors[(size_t)id * NEAREST_K], pair.counts[id] };
+}
+
+void LocationIndex::Nearest(const glm::vec2& pos, LocationType type, uint32_t count,
+    std::vector<LocationNeighbor>& result) const {
+    result.clear();
+    if (count == 0)
+        return;
+    Search(m_Nodes, m_TreeFirst[type], m_TreeFirst[type + 1], 0, pos, count, result);
+}
+
+void LocationIndex::BuildTree(std::vector<Node>& nodes, size_t lo, size_t hi, int depth) {
+    if (hi - lo <= 1)
+        return;
+    size_t mid = (lo + hi) / 2;
+    int axis = depth & 1;
+    std::nth_element(nodes.begin() + lo, nodes.begin() + mid, nodes.begin() + hi,
+        [axis](const Node& l, const Node& r) {
+            return l.pos[axis] < r.pos[axis];
+        });
+    BuildTree(nodes, lo, mid, depth + 1);
+    BuildTree(nodes, mid + 1, hi, depth + 1);
+}
+
+void LocationIndex::Search(const std::vector<Node>& nodes, size_t lo, size_t hi, int depth,
+    const glm::vec2& pos, uint32_t count, std::vector<LocationNeighbor>& result) {
+    if (lo >= hi)
+        return;
+    size_t mid = (lo + hi) / 2;
+    const auto& node = nodes[mid];
+
+    // result 按距离升序，保留最近的 count 个
+    float distance = glm::distance(pos, node.pos);
+    if (result.size() < count || distance < result.back().distance) {
+        auto itr = std::upper_bound(result.begin(), result.end(), distance,
+            [](float d, const LocationNeighbor& n) {
+                return d < n.distance;
+            });
+        result.insert(itr, { node.id, distance });
+        if (result.size() > count)
+            result.pop_back();
+    }
+
+    // 先搜查询点所在的一侧，另一侧只在分割线比当前第 count 近的距离更近时才搜
+    int axis = depth & 1;
+    float delta = pos[axis] - node.pos[axis];
+    if (delta < 0) {
+        Search(nodes, lo, mid, depth + 1, pos, count, result);
+        if (result.size() < count || -delta < result.back().distance)
+            Search(nodes, mid + 1, hi, depth + 1, pos, count, result);
+    }
+    else {
+        Search(nodes, mid + 1, hi, depth + 1, pos, count, result);
+        if (result.size() < count || delta < result.back().distance)
+            Search(nodes, lo, mid, depth + 1, pos, count, result);
+    }
+}
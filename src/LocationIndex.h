@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SeedDatabase.h"
+
+struct LocationNeighbor {
+	uint16_t id;
+	float distance;
+};
+
+struct LocationNeighbors {
+	const LocationNeighbor* first = nullptr;
+	uint32_t count = 0;
+
+	const LocationNeighbor* begin() const {
+		return first;
+	}
+	const LocationNeighbor* end() const {
+		return first + count;
+	}
+	bool empty() const {
+		return count == 0;
+	}
+	const LocationNeighbor& operator[](uint32_t i) const {
+		return first[i];
+	}
+};
+
+// 单个地形的地点空间索引：每类地点（只含该地形出现过的）建一棵静态 2-d 树。
+// 两类地点之间的 k 近邻表在第一次按地点查询该组合时生成，之后按地点查询为 O(1)；
+// 载入地形只建树，切换地形不再为用不到的组合付出代价。
+// 生成近邻表会修改内部缓存，与载入地形一样只应在持有它的线程上调用
+class LocationIndex {
+public:
+	// 每个地点对每类地点保留的近邻数
+	static constexpr uint32_t NEAREST_K = 8;
+
+	void Build(const SeedDatabase& database, const EmdbTerrain& terrain);
+	void Clear();
+
+	// from 类地点 id 在 to 类中的近邻，按距离升序；同类时不含自身，不同类时可能含重合的地点
+	LocationNeighbors Nearest(LocationType from, uint16_t id, LocationType to) const;
+	// 任意位置在 type 类中最近的 count 个地点，按距离升序写入 result
+	void Nearest(const glm::vec2& pos, LocationType type, uint32_t count,
+		std::vector<LocationNeighbor>& result) const;
+
+private:
+	struct Node {
+		glm::vec2 pos;
+		uint16_t id;
+	};
+	// [lo, hi) 区间的中点为子树根，按深度交替以 x、y 划分
+	static void BuildTree(std::vector<Node>& nodes, size_t lo, size_t hi, int depth);
+	static void Search(const std::vector<Node>& nodes, size_t lo, size_t hi, int depth,
+		const glm::vec2& pos, uint32_t count, std::vector<LocationNeighbor>& result);
+
+	// from 类到 to 类的近邻表，行号为 from 类的地点 id，每行 NEAREST_K 个
+	struct PairTable {
+		bool built = false;
+		std::vector<LocationNeighbor> neighbors;
+		std::vector<uint8_t> counts;
+	};
+	void BuildPair(LocationType from, LocationType to, PairTable& pair) const;
+
+private:
+	// 各类地点的树依次存放，type 类占 [m_TreeFirst[type], m_TreeFirst[type + 1])
+	std::vector<Node> m_Nodes;
+	uint32_t m_TreeFirst[eLocationTypeCount + 1]{};
+	uint32_t m_TypeCounts[eLocationTypeCount]{};
+	mutable PairTable m_Pairs[eLocationTypeCount][eLocationTypeCount];
+	// BuildPair 的临时结果，复用以免每个地点分配一次
+	mutable std::vector<LocationNeighbor> m_Result;
+};
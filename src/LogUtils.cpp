@@ -0,0 +1,11 @@
+#include "LogUtils.h"
+#include <cstdarg>
+#include <cstdio>
+
+void LogInfo(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(stderr, fmt, args);
+    va_end(args);
+    std::fflush(stderr);
+}
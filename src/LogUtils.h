@@ -0,0 +1,4 @@
+#pragma once
+
+// 核心库的日志输出，不依赖 SDL，便于无窗口环境下的批处理与服务端使用
+void LogInfo(const char* fmt, ...);
@@ -9,6 +9,8 @@
 #include "GameLoop.h"
 #include "MapViewer.h"
 #include "MapFilter.h"
+#include "Profiler.h"
+#include "ProfilerPanel.h"
 
 class MyGame : public GameLoop {
 protected:
@@ -51,7 +53,9 @@ protected:
         glEnable(GL_BLEND);
         
         m_MapViewer.SetViewport(glm::ivec4(0, 0, m_Size.x, m_Size.y));
-        m_MapViewer.Initialize();
+        m_MapViewer.Initialize(&GameLoop::PostRedraw);
+        m_MapGpuTimer.Initialize();
+        m_ImGuiGpuTimer.Initialize();
 
         m_MapFilter.Initialize(&m_MapViewer);
 
@@ -104,6 +108,10 @@ protected:
                         event.button.y);
                 }
                 break;
+            case SDL_KEYUP:
+                if (event.key.keysym.sym == SDLK_F9)
+                    m_ProfilerPanel.DumpTrace();
+                break;
             case SDL_MOUSEMOTION:
                 if (m_IsDrag) {
                     m_MapViewer.vMove(event.motion.xrel, event.motion.yrel);
@@ -113,7 +121,14 @@ protected:
         }
     }
     void Update(float deltaTime) override {
+        m_MapViewer.Update();
         m_MapViewer.Constrain();
+        if (m_MapViewer.ConsumeChanged())
+            RequestRedraw();
+    }
+    // 渲染时置位的变化在下一帧的 Update 中才被消费，等待事件前先检查
+    bool IsRedrawPending() const override {
+        return m_MapViewer.HasChanged();
     }
 
     void RenderImGui() {
@@ -127,6 +142,7 @@ protected:
         const char* UI_ROOT_WINDOW = "##ui.root";
         const char* UI_PROPERTY_BOX = "视图##ui.property";
         const char* UI_VIEW_BOX = "##ui.view";
+        const char* UI_PROFILER_BOX = "性能##ui.profiler";
 
         const ImGuiViewport* viewport = ImGui::GetMainViewport();
         ImGui::SetNextWindowPos(viewport->WorkPos);
@@ -175,6 +191,7 @@ protected:
                     }
                     
                     ImGui::DockBuilderDockWindow(UI_PROPERTY_BOX, leftBottomNode); // 左下节点
+                    ImGui::DockBuilderDockWindow(UI_PROFILER_BOX, leftBottomNode); // 与属性栏同一节点
 
                     // 结束停靠设置
                     ImGui::DockBuilderFinish(dockID);
@@ -215,13 +232,32 @@ protected:
         }
 
         ImGui::End();
+
+        ImGui::Begin(UI_PROFILER_BOX, nullptr, ImGuiWindowFlags_NoCollapse);
+        m_ProfilerPanel.RenderImGui();
+        ImGui::End();
         
+        PROFILE_SCOPE("ImGui::Render");
         ImGui::Render();
+        m_ImGuiGpuTimer.Begin();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        m_ImGuiGpuTimer.End();
     }
 
     void RenderGL() {
+        m_MapGpuTimer.Begin();
         m_MapViewer.Render();
+        m_MapGpuTimer.End();
+    }
+
+    // 计时查询的结果延迟数帧才可用，取到时计入当前帧
+    void PollGpuTimers() {
+        float ms = m_MapGpuTimer.Poll();
+        if (ms >= 0)
+            Profiler::Get().AddSample("GPU MapViewer::Render", ms);
+        ms = m_ImGuiGpuTimer.Poll();
+        if (ms >= 0)
+            Profiler::Get().AddSample("GPU ImGui", ms);
     }
 
     void Render() override {
@@ -229,6 +265,7 @@ protected:
             m_BgColor.b, m_BgColor.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        PollGpuTimers();
         RenderGL();
 
         RenderImGui();
@@ -242,6 +279,8 @@ protected:
         ImGui::DestroyContext();
 
         m_MapViewer.Cleanup();
+        m_MapGpuTimer.Cleanup();
+        m_ImGuiGpuTimer.Cleanup();
 
         if (m_Context) {
             SDL_GL_DeleteContext(m_Context);
@@ -270,6 +309,9 @@ private:
     
     MapViewer m_MapViewer;
     MapFilter m_MapFilter;
+    ProfilerPanel m_ProfilerPanel;
+    GpuTimer m_MapGpuTimer;
+    GpuTimer m_ImGuiGpuTimer;
 
     bool m_IsDrag = false;
 };
@@ -277,6 +319,7 @@ private:
 int main(int argc, char* argv[]) {
     MyGame game;
     game.SetTargetFPS(60);
+    game.SetOnDemand(true);
     game.Run();
 
     return 0;
@@ -1,28 +1,32 @@
 #include "MapFilter.h"
+#include <chrono>
 #include <set>
 #include <functional>
 
 #include <SDL_Log.h>
 #include <imgui.h>
 
+#include "Profiler.h"
+
 namespace Icons_ {
-    constexpr static const char* SPAWN_POINT = "Padding 1";
-    constexpr static const char* MAJOR_BASE = "Padding 2";
-    constexpr static const char* ROT_BLESSING = "Rot Blessing";
-    constexpr static const char* BOSS = "Boss";
-    constexpr static const char* RED_BOSS = "Red Boss";
-    constexpr static const char* EVERGOAL = "Evergaol";
-    constexpr static const char* CAMP = "Camp";
-    constexpr static const char* SMALL_CAMP = "Small Camp";
-    constexpr static const char* CHURCH = "Church";
-    constexpr static const char* GREAT_CHURCH = "Great Church";
-    constexpr static const char* TOWNSHIP = "Township";
-    constexpr static const char* SORCERERS_RISE = "Sorcerer's Rise";
-    constexpr static const char* RUINS = "Ruins";
-    constexpr static const char* FORT = "Fort";
-    constexpr static const char* CIRCLE = "Circle";
-    constexpr static const char* CART = "Cart";
-    constexpr static const char* DEMON_MERCHANT = "Demon Merchant";
+    constexpr static IconKind SPAWN_POINT = eIconPadding1;
+    constexpr static IconKind MAJOR_BASE = eIconPadding2;
+    constexpr static IconKind ROT_BLESSING = eIconRotBlessing;
+    constexpr static IconKind BOSS = eIconBoss;
+    constexpr static IconKind RED_BOSS = eIconRedBoss;
+    constexpr static IconKind EVERGOAL = eIconEvergaol;
+    constexpr static IconKind CAMP = eIconCamp;
+    constexpr static IconKind SMALL_CAMP = eIconSmallCamp;
+    constexpr static IconKind CHURCH = eIconChurch;
+    constexpr static IconKind GREAT_CHURCH = eIconGreatChurch;
+    constexpr static IconKind TOWNSHIP = eIconTownship;
+    constexpr static IconKind SORCERERS_RISE = eIconSorcerersRise;
+    constexpr static IconKind RUINS = eIconRuins;
+    constexpr static IconKind FORT = eIconFort;
+    constexpr static IconKind CIRCLE = eIconCircle;
+    constexpr static IconKind CART = eIconCart;
+    constexpr static IconKind DEMON_MERCHANT = eIconDemonMerchant;
+    constexpr static IconKind SCOUT = eIconPadding2;
     
     constexpr static float SPAWN_POINT_SCALE_1 = 0.4f;
     constexpr static float SPAWN_POINT_SCALE_2 = 0.8f;
@@ -31,8 +35,9 @@ namespace Icons_ {
     constexpr static float BOSS_SCALE = 0.6f;
     constexpr static float ROT_BLESSING_SCALE = 0.4f;
     constexpr static float DEMON_MERCHANT_SCALE = 0.6f;
+    constexpr static float SCOUT_SCALE = 0.8f;
 
-    const char* From(const std::string& name_, float& scale) {
+    IconKind From(const std::string& name_, float& scale) {
         std::string name = name_;
         std::transform(name.begin(), name.end(), name.begin(), ::tolower);
         scale = 1;
@@ -78,7 +83,7 @@ namespace Icons_ {
             scale = 0.6f;
             return TOWNSHIP;
         }
-        return "";
+        return eIconNone;
     }
 }
 
@@ -90,38 +95,28 @@ static std::string ivec2tostr(const glm::ivec2& pos) {
     return str;
 }
 
-bool IsLandHere(
-    const rapidjson::Value& value,
-    const std::string& landing) {
-    auto itr = value.FindMember("Spawn Point");
-    if (itr == value.MemberEnd())
-        return false;
-    if (landing.compare(itr->value.GetString()) != 0)
-        return false;
-
-    return true;
-}
-
 std::string_view GetCampType(
-    const rapidjson::Value& value,
-    const char* morm, // Minor Base or Major Base
-    const std::string& landing) {
-    std::string_view result;
-    do {
-        auto itr = value.FindMember(morm);
-        if (itr == value.MemberEnd())
-            break;
-        auto campItr = itr->value.FindMember(landing.c_str());
-        if (campItr == itr->value.MemberEnd())
-            break;
-        if (!campItr->value.IsString())
-            break;
-        result = campItr->value.GetString();
-    } while (false);
-    
-    return result;
+    const MapThumbnail& thumbnail,
+    const EmdbSeed& seed,
+    LocationType morm, // Minor Base or Major Base
+    uint16_t landing) {
+    if (landing == EMDB_NO_LOCATION)
+        return std::string_view();
+    return thumbnail.String(thumbnail.ValueOf(seed, morm, landing));
 }
 
+// 同时显示的侦察建议数
+static constexpr int SCOUT_SUGGESTIONS = 3;
+// 详情中列出的相似种子数
+static constexpr uint32_t SIMILAR_SEEDS = 5;
+// 概率图层：各地点最可能的营地、Boss 与永夜牢，图标按概率从 OVERLAY_MIN_SCALE 放大到原尺寸
+static constexpr int OVERLAY_LAYER = 5;
+static constexpr float OVERLAY_MIN_SCALE = 0.3f;
+// 详情所在的图标层，路线只在此层显示时绘制
+static constexpr int DETAIL_LAYER = 3;
+// 决策树提示的下一步检查地点，与侦察建议（第 4 层）分开增删
+static constexpr int TREE_LAYER = 6;
+
 template<class T>
 using Stringify = std::function<std::string(const T&)>;
 
@@ -160,7 +155,19 @@ static bool RenderCombo(const char* label,
 
 void MapFilter::Initialize(MapViewer* view) {
     m_Viewer = view;
+    // 点击落地点图标即选择该落地点
+    m_Viewer->SetLayerCallback(1,
+        [](MapFilter* filter, uint32_t idx) {
+            if (idx < filter->m_Landings.size()) {
+                filter->m_LandingIndex = (int)idx;
+                filter->OnFilterLanding();
+            }
+        });
     m_Variables.Initialize();
+    if (!m_Database.Open("seeds.emdb")) {
+        SDL_Log("Compile seed database from json\n");
+        m_Database.Build(m_Variables.GetTerrains());
+    }
     auto& terrain = m_Variables.GetTerrains();
     m_Terrains.assign(terrain.begin(), terrain.end());
 }
@@ -175,6 +182,12 @@ static int GetFlags(std::set<int>&& values) {
 
 void MapFilter::RenderImGui() {
     using namespace std;
+    PROFILE_SCOPE("MapFilter::RenderImGui");
+
+    if (ImGui::CollapsingHeader("全地形搜索")) {
+        RenderSearch();
+        ImGui::Separator();
+    }
     
     do {
         if (FilterTerrain()) {
@@ -184,6 +197,12 @@ void MapFilter::RenderImGui() {
         if (m_TerrainIndex < 0 || m_TerrainIndex >= m_Terrains.size())
             break;
 
+        if (ImGui::Checkbox("概率图层", &m_ShowOverlay)) {
+            ShowLayers(m_LayerFlags);
+            UpdateOverlay();
+        }
+        RenderOverlayTooltip();
+
         if (FilterLanding()) {
             OnFilterLanding();
         }
@@ -191,6 +210,13 @@ void MapFilter::RenderImGui() {
         if (m_LandingIndex < 0 || m_LandingIndex >= m_Landings.size())
             break;
 
+        if (FilterTree()) {
+            OnFilterTree();
+        }
+
+        if (m_Tree.IsValid() && m_Tree.IsLeaf())
+            break;
+
         if (FilterSmallCampType()) {
             OnFilterSmallCampType();
         }
@@ -198,30 +224,139 @@ void MapFilter::RenderImGui() {
         if (m_SmallCampTypeIndex < 0 || m_SmallCampTypeIndex >= m_SmallCampTypes.size())
             break;
 
+        FilterScout();
+
         if (FilterNearCamp()) {
             OnFilterNearCamp();
         }
+    } while (false);
 
-        if (m_CampTypeIndex < 0 || m_CampTypeIndex >= m_CampTypes.size())
-            break;
+    // 详情不依赖上面的逐级筛选，全地形搜索直接选中的种子也从这里显示
+    if (m_DetailSeed)
+        RenderDetail();
+}
+
+void MapFilter::RenderDetail() {
+    const auto& detail = m_MapDetail;
+    ImGui::Text("地图索引: %d", detail.index);
+    ImGui::Text("夜王: %s", detail.nightlord.c_str());
+    ImGui::Text("第一夜BOSS: %s", detail.night_1_boss.c_str());
+    ImGui::Text("第一夜BOSS: %s", detail.night_2_boss.c_str());
+    if (detail.special_event.empty()) {
+        ImGui::Text("特殊事件: %s", detail.nightlord.c_str());
+        if (!detail.extra_boss.empty()) {
+            ImGui::Text("额外夜晚BOSS: %s", detail.extra_boss.c_str());
+        }
+    }
+    if (!detail.castle_type.empty()) {
+        ImGui::Text("主城类型: %s", detail.castle_type.c_str());
+        ImGui::Text("主城地下: %s", detail.castle_basement.c_str());
+        ImGui::Text("主城楼顶: %s", detail.castle_rooftop.c_str());
+    }
+
+    // 从落地点经过勾选种类的全部地点到第一天缩圈，长度为地图像素的直线距离
+    if (m_DetailSeed && ImGui::TreeNode("路线")) {
+        bool changed = ImGui::CheckboxFlags("大型据点", &m_RouteTypes, 1u << eMajorBase);
+        changed = ImGui::CheckboxFlags("永夜牢", &m_RouteTypes, 1u << eEvergaol) || changed;
+        changed = ImGui::CheckboxFlags("野外BOSS", &m_RouteTypes, 1u << eFieldBoss) || changed;
+        if (changed) {
+            UpdateRoute();
+            ShowLayers(m_LayerFlags);
+        }
+        if (m_RoutePoints.size() >= 2) {
+            ImGui::Text("途经 %u 处, 长度 %.0f (%.3f ms)", (unsigned)m_RoutePoints.size() - 2,
+                m_RouteLength, m_RouteTime);
+        }
+        ImGui::TreePop();
+    }
 
-        const auto& detail = m_MapDetail;
-        ImGui::Text("地图索引: %d", detail.index);
-        ImGui::Text("夜王: %s", detail.nightlord.c_str());
-        ImGui::Text("第一夜BOSS: %s", detail.night_1_boss.c_str());
-        ImGui::Text("第一夜BOSS: %s", detail.night_2_boss.c_str());
-        if (detail.special_event.empty()) {
-            ImGui::Text("特殊事件: %s", detail.nightlord.c_str());
-            if (!detail.extra_boss.empty()) {
-                ImGui::Text("额外夜晚BOSS: %s", detail.extra_boss.c_str());
+    // 距离为取值不同的地点与字段数，点击切换到该种子
+    if (!m_SimilarSeeds.empty() && ImGui::TreeNode("相似种子")) {
+        for (const auto& similar : m_SimilarSeeds) {
+            const auto& seed = m_Thumbnail.Seed(similar.seed);
+            std::string item = std::to_string(seed.index) + " (距离 "
+                + std::to_string(similar.distance) + ")##similar";
+            if (ImGui::Selectable(item.c_str())) {
+                ShowDetail(seed);
+                break;
             }
         }
-        if (!detail.castle_type.empty()) {
-            ImGui::Text("主城类型: %s", detail.castle_type.c_str());
-            ImGui::Text("主城地下: %s", detail.castle_basement.c_str());
-            ImGui::Text("主城楼顶: %s", detail.castle_rooftop.c_str());
+        ImGui::TreePop();
+    }
+}
+
+// 全地形搜索的"不限"选项
+static constexpr uint16_t SEARCH_ANY = 0xFFFF;
+
+void MapFilter::RenderSearch() {
+    if (!m_SearchLoaded) {
+        m_SearchLoaded = true;
+        m_Search.Load(m_Database, m_Variables.GetTerrains());
+        m_SearchNightlords = m_Search.Values(eSeedNightlord);
+        m_SearchNightlords.insert(m_SearchNightlords.begin(), SEARCH_ANY);
+        m_SearchEvents = m_Search.Values(eSeedSpecialEvent);
+        m_SearchEvents.insert(m_SearchEvents.begin(), SEARCH_ANY);
+        RunSearch();
+    }
+
+    auto tostr = [this](const uint16_t& value) {
+        return std::string(value == SEARCH_ANY ? "不限" : m_Database.String(value));
+    };
+    bool changed = RenderCombo("夜王##search", m_SearchNightlords, m_SearchNightlordIndex, tostr);
+    changed = RenderCombo("特殊事件##search", m_SearchEvents, m_SearchEventIndex, tostr) || changed;
+    if (changed)
+        RunSearch();
+
+    ImGui::Text("匹配种子: %u (%.3f ms)", (unsigned)m_SearchMatches.size(), m_SearchTime);
+    for (uint32_t t = 0; t < m_Search.TerrainCount(); t++) {
+        std::string name(m_Search.TerrainName(t));
+        ImGui::BulletText("%s: %u", name.c_str(), m_Search.MatchCount(t));
+    }
+
+    if (ImGui::BeginListBox("##search results")) {
+        ImGuiListClipper clipper;
+        clipper.Begin((int)m_SearchMatches.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const auto& match = m_SearchMatches[i];
+                const auto& seed = m_Search.Thumbnail(match.terrain).Seed(match.seed);
+                std::string item = std::string(m_Search.TerrainName(match.terrain))
+                    + " - " + std::to_string(seed.index) + "##search" + std::to_string(i);
+                if (ImGui::Selectable(item.c_str(), m_SearchSelected == i)) {
+                    m_SearchSelected = i;
+                    OnSelectSearch(match);
+                }
+            }
         }
-    } while (false);
+        ImGui::EndListBox();
+    }
+}
+
+void MapFilter::RunSearch() {
+    SeedQuery query;
+    uint16_t nightlord = m_SearchNightlords[m_SearchNightlordIndex];
+    if (nightlord != SEARCH_ANY)
+        query.Where(eSeedNightlord, nightlord);
+    uint16_t event = m_SearchEvents[m_SearchEventIndex];
+    if (event != SEARCH_ANY)
+        query.Where(eSeedSpecialEvent, event);
+
+    auto start = std::chrono::steady_clock::now();
+    m_Search.Run(query, m_SearchMatches);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    m_SearchTime = elapsed.count();
+    m_SearchSelected = -1;
+}
+
+void MapFilter::OnSelectSearch(const SeedMatch& match) {
+    // 切换到种子所在的地形并直接显示详情
+    auto name = m_Search.TerrainName(match.terrain);
+    auto itr = std::find(m_Terrains.begin(), m_Terrains.end(), name);
+    if (itr == m_Terrains.end())
+        return;
+    m_TerrainIndex = (int)std::distance(m_Terrains.begin(), itr);
+    OnFilterTerrain();
+    ShowDetail(m_Thumbnail.Seed(match.seed));
 }
 
 bool MapFilter::FilterTerrain() {
@@ -238,51 +373,55 @@ bool MapFilter::FilterTerrain() {
 void MapFilter::OnFilterTerrain() {
     const char* terrain = m_Terrains[m_TerrainIndex].data();
     m_Viewer->ReloadMap(terrain);
-    m_Thumbnail.LoadMap(terrain);
+    m_Thumbnail.LoadMap(m_Database, terrain);
+    m_Index.Build(m_Thumbnail);
+    m_Similarity.Build(m_Index);
+    m_Stats.Reset(m_Index, { eSeedMinorBase, eSeedMajorBase, eSeedEvergaol, eSeedFieldBoss });
+    m_Route.Reset(m_Thumbnail);
+    m_Query.Clear();
+    m_Scout.Clear();
+    m_Tree.Clear();
+    m_TreeChecks.clear();
 
     // reset
-    std::set<std::string_view> tmp;
-    m_Thumbnail.Foreach([&tmp](const rapidjson::Value& value) {
-        auto itr = value.FindMember("Spawn Point");
-        if (itr == value.MemberEnd())
-            return;
-        tmp.insert(itr->value.GetString());
-    });
-    m_Landings.assign(tmp.begin(), tmp.end());
+    m_Landings.clear();
+    for (uint16_t landing : m_Index.Values(eSeedSpawnPoint, 0)) {
+        if (m_Thumbnail.Query(eMinorBase, landing))
+            m_Landings.push_back(landing);
+    }
+    std::sort(m_Landings.begin(), m_Landings.end(),
+        [this](uint16_t l, uint16_t r) {
+            return strcmp(m_Thumbnail.Name(eMinorBase, l),
+                m_Thumbnail.Name(eMinorBase, r)) < 0;
+        });
     m_LandingIndex = -1;
     m_SmallCampTypes.clear();
     m_SmallCampTypeIndex = -1;
     m_CampTypes.clear();
     m_CampTypeIndex = -1;
     m_MapDetail.Reset();
+    m_SimilarSeeds.clear();
+    m_DetailSeed = nullptr;
+    UpdateRoute();
 
     // map icon
-    m_Viewer->RemoveAllButtons(1);
+    m_Viewer->RemoveIcons(1);
+    m_LandingIcons.clear();
     for (int i = 0; i < m_Landings.size(); i++) {
-        auto& landing = m_Landings[i];
-        auto pos = m_Thumbnail.Query(eMinorBase, landing.data());
-        if (!pos) continue;
-        m_Viewer->AddButton(*pos, Icons_::SPAWN_POINT, 1)
-            .SetLayer(1)
-            .SetScale(Icons_::SPAWN_POINT_SCALE_1)
-            .SetUserData((void*)i)
-            .SetCallback(
-                [](MapFilter* filter, void* ud) {
-                    int idx = (int)ud;
-                    if (idx >= 0 && idx < filter->m_Landings.size()) {
-                        filter->m_LandingIndex = idx;
-                        filter->OnFilterLanding();
-                    }
-                });
-    }
-    m_Viewer->SetButtonFlagBits(GetFlags({1}));
+        auto pos = m_Thumbnail.Query(eMinorBase, m_Landings[i]);
+        m_LandingIcons.push_back(pos
+            ? m_Viewer->AddIcon(*pos, Icons_::SPAWN_POINT, 1, Icons_::SPAWN_POINT_SCALE_1, (uint32_t)i)
+            : INVALID_ICON);
+    }
+    ShowLayers(GetFlags({1}));
+    UpdateOverlay();
 }
 
 bool MapFilter::FilterLanding() {
     // 选择落地点
     bool changed = RenderCombo("落地点", m_Landings, m_LandingIndex,
-        [this](const std::string_view& loc) {
-            if (auto pos = m_Thumbnail.Query(eMinorBase, loc.data()))
+        [this](const uint16_t& loc) {
+            if (auto pos = m_Thumbnail.Query(eMinorBase, loc))
                 return ivec2tostr(*pos);
             return std::string("--------");
         }
@@ -292,50 +431,125 @@ bool MapFilter::FilterLanding() {
 }
 
 void MapFilter::OnFilterLanding() {
-    std::set<std::string_view> tmp;
-    m_Thumbnail.Foreach([&tmp, this](const rapidjson::Value& value) {
-        auto& landing = m_Landings[m_LandingIndex];
-        if (!IsLandHere(value, landing))
-            return;
-        auto campType = GetCampType(value, "Minor Base", landing);
-
-        tmp.insert(campType);
-    });
+    auto landing = m_Landings[m_LandingIndex];
+    m_Query.Clear();
+    m_Query.Where(eSeedSpawnPoint, landing);
+    m_TreeChecks.clear();
+    auto result = m_Query.Run(m_Index);
 
     // reset
-    m_SmallCampTypes.assign(tmp.begin(), tmp.end());;
-    auto& landcamp = m_Landings[m_LandingIndex];
-    m_NearCamp = m_Thumbnail.Near(landcamp.data());
+    m_SmallCampTypes.clear();
+    if (auto histogram = result.Histogram(eSeedMinorBase, landing)) {
+        for (auto& count : histogram->counts) {
+            m_SmallCampTypes.push_back(count.first);
+        }
+    }
+    std::sort(m_SmallCampTypes.begin(), m_SmallCampTypes.end(),
+        [this](uint16_t l, uint16_t r) {
+            return strcmp(m_Thumbnail.String(l), m_Thumbnail.String(r)) < 0;
+        });
+    m_NearCamp = m_Thumbnail.Near(m_Landings[m_LandingIndex]);
+    m_Scout.Clear();
     m_SmallCampTypeIndex = -1;
     m_CampTypes.clear();
     m_CampTypeIndex = -1;
     m_MapDetail.Reset();
+    m_DetailSeed = nullptr;
+    UpdateRoute();
 
     // map icon
-    m_Viewer->ForeachButton([this](MapButton& btn) {
-        if (btn.Name() != Icons_::SPAWN_POINT) {
-            btn.Delete();
-            return;
-        }
-        if (m_LandingIndex == (int)btn.UserData())
-            btn.SetScale(Icons_::SPAWN_POINT_SCALE_2);
-        else
-            btn.SetScale(Icons_::SPAWN_POINT_SCALE_1);
-    });
+    m_Viewer->RemoveIcons(2);
+    m_Viewer->RemoveIcons(3);
+    m_Viewer->RemoveIcons(4);
+    m_Viewer->RemoveIcons(TREE_LAYER);
+    for (int i = 0; i < m_LandingIcons.size(); i++) {
+        m_Viewer->SetIconScale(m_LandingIcons[i], i == m_LandingIndex
+            ? Icons_::SPAWN_POINT_SCALE_2 : Icons_::SPAWN_POINT_SCALE_1);
+    }
+
+    if (auto pos = m_Thumbnail.Query(eMajorBase, m_NearCamp)) {
+        m_Viewer->AddIcon(*pos, Icons_::MAJOR_BASE, 2, Icons_::MAJOR_BASE_SCALE);
+    }
+    ShowLayers(GetFlags({ 1,2 }));
+
+    m_Tree.Reset(m_Thumbnail, landing);
+    OnFilterTree();
+    UpdateOverlay();
+}
+
+bool MapFilter::FilterTree() {
+    // 沿预先生成的决策树提示下一步检查的地点
+    if (!m_Tree.IsValid())
+        return false;
+
+    if (m_Tree.IsLeaf()) {
+        // 从落地点重新开始，丢弃决策树与侦察的全部观察
+        if (ImGui::Button("重新识别"))
+            OnFilterLanding();
+        return false;
+    }
+
+    const auto& node = m_Tree.Node();
+    const auto& info = GetSeedFieldInfo(m_Tree.Field());
+    ImGui::Text("下一步检查: %s - %s (剩余种子 %u)", info.name,
+        m_Thumbnail.Name(info.location, node.slot), (unsigned)node.seedCount);
+
+    std::vector<uint16_t> values;
+    for (uint32_t i = 0; i < m_Tree.BranchCount(); i++) {
+        values.push_back(m_Tree.BranchValue(i));
+    }
+    int index = -1;
+    if (RenderCombo("检查结果", values, index,
+        [this](const uint16_t& value) {
+            return std::string(m_Thumbnail.String(value));
+        })) {
+        SeedField field = m_Tree.Field();
+        uint16_t slot = node.slot;
+        if (!m_Tree.Check(values[index]))
+            return false;
+        ObserveTree(field, slot, values[index]);
+        return true;
+    }
+    return false;
+}
+
+void MapFilter::ObserveTree(SeedField field, uint16_t slot, uint16_t value) {
+    // 候选数、侦察排序与概率图层都要反映决策树上的观察
+    m_TreeChecks.push_back({ field, slot, { value } });
+    m_Query.Where(field, slot, value);
+    if (m_SmallCampTypeIndex >= 0) {
+        m_Scout.Observe(field, slot, value);
+        UpdateCandidates();
+    }
+    else {
+        UpdateOverlay();
+    }
+}
+
+void MapFilter::OnFilterTree() {
+    if (!m_Tree.IsValid())
+        return;
+
+    // 到达叶节点即确定了种子
+    m_Viewer->RemoveIcons(TREE_LAYER);
+    if (m_Tree.IsLeaf()) {
+        ShowDetail(m_Thumbnail.Seed(m_Tree.Node().seed));
+        return;
+    }
 
-    if (auto pos = m_Thumbnail.Query(eMajorBase, m_NearCamp.c_str())) {
-        m_Viewer->RemoveAllButtons(2);
-        m_Viewer->AddButton(*pos, Icons_::MAJOR_BASE, 2)
-            .SetScale(Icons_::MAJOR_BASE_SCALE);
+    // map icon
+    const auto& info = GetSeedFieldInfo(m_Tree.Field());
+    if (auto pos = m_Thumbnail.Query(info.location, m_Tree.Node().slot)) {
+        m_Viewer->AddIcon(*pos, Icons_::SCOUT, TREE_LAYER, Icons_::SCOUT_SCALE);
     }
-    m_Viewer->SetButtonFlagBits(GetFlags({ 1,2 }));
+    ShowLayers(GetFlags({ 1,2,4,TREE_LAYER }));
 }
 
 bool MapFilter::FilterSmallCampType() {
     // 选择落地营地
     bool changed = RenderCombo("落地营地", m_SmallCampTypes, m_SmallCampTypeIndex,
-        [](const std::string_view& camp) {
-            return std::string(camp);
+        [this](const uint16_t& camp) {
+            return std::string(m_Thumbnail.String(camp));
         }
     );
 
@@ -343,22 +557,77 @@ bool MapFilter::FilterSmallCampType() {
 }
 
 void MapFilter::OnFilterSmallCampType() {
-    m_CampTypes.clear();
-    m_Thumbnail.Foreach([this](const rapidjson::Value& value) {
-        auto& landing = m_Landings[m_LandingIndex];
-        if (!IsLandHere(value, landing))
-            return;
+    // 重新选择营地时丢弃之前的侦察结果
+    auto landing = m_Landings[m_LandingIndex];
+    m_Query.Clear();
+    m_Query.Where(eSeedSpawnPoint, landing)
+        .Where(eSeedMinorBase, landing, m_SmallCampTypes[m_SmallCampTypeIndex]);
+    for (const auto& check : m_TreeChecks) {
+        m_Query.Where(check.field, check.slot, check.values[0]);
+    }
+    m_Scout.Reset(m_Index, m_Query.Match(m_Index));
+    UpdateCandidates();
+}
+
+bool MapFilter::FilterScout() {
+    // 按信息增益排序的侦察建议，选择看到的内容以缩小候选
+    const auto& suggestions = m_Scout.Suggestions();
+    if (suggestions.empty())
+        return false;
+
+    ImGui::Text("候选种子: %u", m_Scout.CandidateCount());
+    for (int i = 0; i < SCOUT_SUGGESTIONS && i < suggestions.size(); i++) {
+        const auto suggestion = suggestions[i];
+        const auto& info = GetSeedFieldInfo(suggestion.field);
+        ImGui::Text("%s - %s (%.2f bit, 剩余 %.1f)", info.name,
+            m_Thumbnail.Name(info.location, suggestion.slot),
+            suggestion.entropy, suggestion.expected);
+
+        const auto& values = m_Scout.Values(suggestion.field, suggestion.slot);
+        int index = -1;
+        std::string label = "侦察结果##scout" + std::to_string(i);
+        if (RenderCombo(label.c_str(), values, index,
+            [this](const uint16_t& value) {
+                return std::string(m_Thumbnail.String(value));
+            })) {
+            OnFilterScout(suggestion.field, suggestion.slot, values[index]);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MapFilter::OnFilterScout(SeedField field, uint16_t slot, uint16_t value) {
+    m_Query.Where(field, slot, value);
+    m_Scout.Observe(field, slot, value);
+    UpdateCandidates();
+}
 
-        auto idxItr = value.FindMember("index");
-        if (idxItr == value.MemberEnd())
-            return;
-        int mapIdx = value["index"].GetInt();
+void MapFilter::UpdateCandidates() {
+    m_CampTypes.clear();
+    m_Scout.Candidates().Foreach([this](uint32_t i) {
+        const auto& seed = m_Thumbnail.Seed(i);
+        int mapIdx = seed.index;
 
-        std::string campType = GetCampType(value, "Major Base", m_NearCamp).data();
+        std::string campType = GetCampType(m_Thumbnail, seed, eMajorBase, m_NearCamp).data();
         m_CampTypes[mapIdx] = campType;
     });
     m_CampTypeIndex = -1;
     m_MapDetail.Reset();
+    m_DetailSeed = nullptr;
+    UpdateRoute();
+
+    // map icon
+    m_Viewer->RemoveIcons(4);
+    const auto& suggestions = m_Scout.Suggestions();
+    for (int i = 0; i < SCOUT_SUGGESTIONS && i < suggestions.size(); i++) {
+        const auto& info = GetSeedFieldInfo(suggestions[i].field);
+        auto pos = m_Thumbnail.Query(info.location, suggestions[i].slot);
+        if (!pos) continue;
+        m_Viewer->AddIcon(*pos, Icons_::SCOUT, 4, Icons_::SCOUT_SCALE);
+    }
+    ShowLayers(GetFlags({ 1,2,4,TREE_LAYER }));
+    UpdateOverlay();
 }
 
 bool MapFilter::FilterNearCamp() {
@@ -377,57 +646,164 @@ void MapFilter::OnFilterNearCamp() {
     std::advance(itr, m_CampTypeIndex);
     m_MapDetail.index = itr->first;
 
-    auto target = m_Thumbnail.Find([this](const rapidjson::Value& value) {
-        auto idxItr = value.FindMember("index");
-        if (idxItr == value.MemberEnd())
-            return false;
-        int mapIdx = value["index"].GetInt();
-        return m_MapDetail.index == mapIdx;
+    auto target = m_Thumbnail.Find([this](const EmdbSeed& seed) {
+        return m_MapDetail.index == seed.index;
     });
 
     if (target)
-        m_MapDetail.Load(*target, m_Thumbnail);
+        ShowDetail(*target);
+}
+
+void MapFilter::ShowDetail(const EmdbSeed& seed) {
+    // Load 跳过空值与缺失的坐标，切换种子时先清空上一个种子的详情
+    m_MapDetail.Reset();
+    m_MapDetail.Load(seed, m_Thumbnail);
+    m_SimilarSeeds.clear();
+    for (uint32_t i = 0; i < m_Thumbnail.SeedCount(); i++) {
+        if (&m_Thumbnail.Seed(i) == &seed) {
+            m_Similarity.Nearest(i, SIMILAR_SEEDS, m_SimilarSeeds);
+            break;
+        }
+    }
+    m_DetailSeed = &seed;
+    UpdateRoute();
 
     auto& detail = m_MapDetail;
-    m_Viewer->RemoveAllButtons(3);
-    m_Viewer->AddButton(detail.spawn_point, Icons_::SPAWN_POINT, 3);
-    m_Viewer->AddButton(detail.day_1_circle, Icons_::CIRCLE, 3);
-    m_Viewer->AddButton(detail.day_2_circle, Icons_::CIRCLE, 3);
+    m_Viewer->RemoveIcons(3);
+    // 种子中没有的单个地点保持 Reset 时的 FLT_MAX，不添加图标
+    auto addIcon = [this](const glm::vec2& pos, IconKind kind, float scale) {
+        if (MapDetail::IsPresent(pos))
+            m_Viewer->AddIcon(pos, kind, 3, scale);
+    };
+    addIcon(detail.spawn_point, Icons_::SPAWN_POINT, 1.f);
+    addIcon(detail.day_1_circle, Icons_::CIRCLE, 1.f);
+    addIcon(detail.day_2_circle, Icons_::CIRCLE, 1.f);
     for (const auto& e : detail.major) {
         float scale = 1;
-        const auto* name = Icons_::From(e.second, scale);
-        m_Viewer->AddButton(e.first, name, 3)
-            .SetScale(scale);
+        IconKind kind = Icons_::From(e.second, scale);
+        m_Viewer->AddIcon(e.first, kind, 3, scale);
     }
     for (const auto& e : detail.minor) {
         float scale = 1;
-        const auto* name = Icons_::From(e.second, scale);
-        m_Viewer->AddButton(e.first, name, 3)
-            .SetScale(scale);
+        IconKind kind = Icons_::From(e.second, scale);
+        m_Viewer->AddIcon(e.first, kind, 3, scale);
     }
     for (const auto& e : detail.evergaol) {
-        m_Viewer->AddButton(e.first, Icons_::EVERGOAL, 3)
-            .SetScale(Icons_::EVERGOAL_SCALE);
+        m_Viewer->AddIcon(e.first, Icons_::EVERGOAL, 3, Icons_::EVERGOAL_SCALE);
     }
     for (const auto& e : detail.field) {
         if (e.second[0] == '*') {
-            m_Viewer->AddButton(e.first, Icons_::RED_BOSS, 3)
-                .SetScale(Icons_::BOSS_SCALE);
+            m_Viewer->AddIcon(e.first, Icons_::RED_BOSS, 3, Icons_::BOSS_SCALE);
         }
         else {
-            m_Viewer->AddButton(e.first, Icons_::BOSS, 3)
-                .SetScale(Icons_::BOSS_SCALE);
+            m_Viewer->AddIcon(e.first, Icons_::BOSS, 3, Icons_::BOSS_SCALE);
         }
     }
     for (const auto& e : detail.rotted_woods) {
-        m_Viewer->AddButton(e.first, Icons_::RED_BOSS, 3)
-            .SetScale(Icons_::BOSS_SCALE);
-    }
-    m_Viewer->AddButton(detail.rot_blessing, Icons_::ROT_BLESSING, 3)
-        .SetScale(Icons_::ROT_BLESSING_SCALE);
-    m_Viewer->AddButton(detail.frenzy_tower, Icons_::ROT_BLESSING, 3)
-        .SetScale(Icons_::ROT_BLESSING_SCALE);
-    m_Viewer->AddButton(detail.demon_merchant, Icons_::DEMON_MERCHANT, 3)
-        .SetScale(Icons_::DEMON_MERCHANT_SCALE);
-    m_Viewer->SetButtonFlagBits(GetFlags({ 3 }));
+        m_Viewer->AddIcon(e.first, Icons_::RED_BOSS, 3, Icons_::BOSS_SCALE);
+    }
+    addIcon(detail.rot_blessing, Icons_::ROT_BLESSING, Icons_::ROT_BLESSING_SCALE);
+    addIcon(detail.frenzy_tower, Icons_::ROT_BLESSING, Icons_::ROT_BLESSING_SCALE);
+    addIcon(detail.demon_merchant, Icons_::DEMON_MERCHANT, Icons_::DEMON_MERCHANT_SCALE);
+    ShowLayers(GetFlags({ 3 }));
+}
+
+void MapFilter::UpdateRoute() {
+    m_RoutePoints.clear();
+    m_RouteLength = 0;
+    m_RouteTime = 0;
+    if (!m_DetailSeed)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    m_RouteLength = m_Route.Plan(*m_DetailSeed, m_RouteTypes, m_RoutePoints);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    m_RouteTime = elapsed.count();
+}
+
+void MapFilter::ShowLayers(int flags) {
+    m_LayerFlags = flags;
+    m_Viewer->SetIconFlagBits(m_ShowOverlay ? flags | (1 << OVERLAY_LAYER) : flags);
+    if (flags & (1 << DETAIL_LAYER))
+        m_Viewer->SetRoute(m_RoutePoints);
+    else
+        m_Viewer->ClearRoute();
+}
+
+void MapFilter::UpdateOverlay() {
+    m_Viewer->RemoveIcons(OVERLAY_LAYER);
+    if (!m_ShowOverlay)
+        return;
+
+    // 侦察中为侦察的候选集合，否则为当前约束的匹配结果
+    const auto& scouted = m_Scout.Candidates();
+    m_Stats.Update(scouted.Size() == m_Index.SeedCount() ? scouted : m_Query.Match(m_Index));
+    if (m_Stats.CandidateCount() == 0)
+        return;
+
+    for (uint32_t s = 0; s < m_Stats.SlotCount(); s++) {
+        const auto& slot = m_Stats.GetSlot(s);
+        const auto& info = GetSeedFieldInfo(slot.field);
+        auto pos = m_Thumbnail.Query(info.location, slot.slot);
+        if (!pos)
+            continue;
+
+        // 最可能出现的非空取值
+        uint16_t value = EMDB_EMPTY_STRING;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < slot.count; i++) {
+            if (m_Stats.Value(slot, i) != EMDB_EMPTY_STRING && m_Stats.Count(slot, i) > count) {
+                value = m_Stats.Value(slot, i);
+                count = m_Stats.Count(slot, i);
+            }
+        }
+        if (count == 0)
+            continue;
+
+        const char* name = m_Thumbnail.String(value);
+        float scale = 1;
+        IconKind kind;
+        if (slot.field == eSeedEvergaol) {
+            kind = Icons_::EVERGOAL;
+            scale = Icons_::EVERGOAL_SCALE;
+        }
+        else if (slot.field == eSeedFieldBoss) {
+            kind = name[0] == '*' ? Icons_::RED_BOSS : Icons_::BOSS;
+            scale = Icons_::BOSS_SCALE;
+        }
+        else {
+            kind = Icons_::From(name, scale);
+        }
+        if (kind == eIconNone)
+            continue;
+
+        float probability = (float)count / m_Stats.CandidateCount();
+        scale *= OVERLAY_MIN_SCALE + (1 - OVERLAY_MIN_SCALE) * probability;
+        m_Viewer->AddIcon(*pos, kind, OVERLAY_LAYER, scale, s);
+    }
+}
+
+void MapFilter::RenderOverlayTooltip() {
+    // 鼠标悬停在概率图层的图标上时显示该地点的完整分布
+    const auto& io = ImGui::GetIO();
+    uint32_t s = 0;
+    if (!m_ShowOverlay || io.WantCaptureMouse
+        || !m_Viewer->PickIcon((int)io.MousePos.x, (int)io.MousePos.y, OVERLAY_LAYER, s)
+        || s >= m_Stats.SlotCount())
+        return;
+
+    const auto& slot = m_Stats.GetSlot(s);
+    const auto& info = GetSeedFieldInfo(slot.field);
+    SeedHistogram histogram;
+    m_Stats.Histogram(slot, histogram);
+
+    ImGui::BeginTooltip();
+    ImGui::Text("%s - %s (候选种子 %u)", info.name,
+        m_Thumbnail.Name(info.location, slot.slot), m_Stats.CandidateCount());
+    ImGui::Separator();
+    for (const auto& count : histogram.counts) {
+        const char* name = count.first == EMDB_EMPTY_STRING ? "(无)" : m_Thumbnail.String(count.first);
+        ImGui::Text("%5.1f%%  %s", 100.f * count.second / m_Stats.CandidateCount(), name);
+    }
+    ImGui::EndTooltip();
 }
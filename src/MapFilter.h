@@ -1,6 +1,13 @@
 #pragma once
 
 #include "MapViewer.h"
+#include "RoutePlanner.h"
+#include "SeedQuery.h"
+#include "SeedScout.h"
+#include "SeedSearch.h"
+#include "SeedSimilarity.h"
+#include "SeedStats.h"
+#include "SeedTree.h"
 
 class MapFilter {
 public:
@@ -15,29 +22,80 @@ private:
 	void OnFilterTerrain();
 	bool FilterLanding();
 	void OnFilterLanding();
+	bool FilterTree();
+	void OnFilterTree();
+	// 决策树上确认的观察同样计入查询与侦察
+	void ObserveTree(SeedField field, uint16_t slot, uint16_t value);
 	bool FilterSmallCampType();
 	void OnFilterSmallCampType();
 	bool FilterNearCamp();
 	void OnFilterNearCamp();
+	bool FilterScout();
+	void OnFilterScout(SeedField field, uint16_t slot, uint16_t value);
+	void UpdateCandidates();
+	void ShowDetail(const EmdbSeed& seed);
+	void RenderDetail();
+	// 为当前详情的种子重新规划路线
+	void UpdateRoute();
+	void RenderSearch();
+	void RunSearch();
+	void OnSelectSearch(const SeedMatch& match);
+	// 显示的图标层，开启概率图层时附加其所在层，显示详情层时同时绘制路线
+	void ShowLayers(int flags);
+	void UpdateOverlay();
+	void RenderOverlayTooltip();
 
 private:
 	MapViewer* m_Viewer = nullptr;
 
+	SeedDatabase m_Database;
 	MapThumbnail m_Thumbnail;
+	SeedIndex m_Index;
+	SeedQuery m_Query;
+	SeedScout m_Scout;
+	SeedSimilarity m_Similarity;
+	SeedStats m_Stats;
+	bool m_ShowOverlay = false;
+	int m_LayerFlags = 0;
+	SeedTreeWalker m_Tree;
+	// 沿决策树已确认的观察，重新选择落地营地时保留
+	std::vector<SeedConstraint> m_TreeChecks;
 	Variables m_Variables;
 
 	std::vector<std::string> m_Terrains;
 	int m_TerrainIndex = -1;
 
-	std::vector<std::string> m_Landings;
+	std::vector<uint16_t> m_Landings;
+	// 与 m_Landings 一一对应的地图图标
+	std::vector<IconHandle> m_LandingIcons;
 	int m_LandingIndex = -1;
 
-	std::vector<std::string> m_SmallCampTypes;
+	std::vector<uint16_t> m_SmallCampTypes;
 	int m_SmallCampTypeIndex = -1;
 
-	std::string m_NearCamp;
+	uint16_t m_NearCamp = EMDB_NO_LOCATION;
 	std::map<int, std::string> m_CampTypes;
 	int m_CampTypeIndex;
 
 	MapDetail m_MapDetail;
+	// 与当前详情最相似的种子
+	std::vector<SeedDistance> m_SimilarSeeds;
+	// 当前详情的种子，路线随详情图层一同显示
+	const EmdbSeed* m_DetailSeed = nullptr;
+	RoutePlanner m_Route;
+	unsigned int m_RouteTypes = RoutePlanner::STOP_TYPES;
+	std::vector<glm::vec2> m_RoutePoints;
+	float m_RouteLength = 0;
+	double m_RouteTime = 0;
+
+	// 全地形搜索，首次展开时载入全部地形
+	SeedSearch m_Search;
+	bool m_SearchLoaded = false;
+	std::vector<uint16_t> m_SearchNightlords;
+	int m_SearchNightlordIndex = 0;
+	std::vector<uint16_t> m_SearchEvents;
+	int m_SearchEventIndex = 0;
+	std::vector<SeedMatch> m_SearchMatches;
+	double m_SearchTime = 0;
+	int m_SearchSelected = -1;
 };
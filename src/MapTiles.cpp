@@ -0,0 +1,191 @@
+#include "MapTiles.h"
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+
+bool MapTiles::Open(const char* path) {
+    Cleanup();
+    if (!m_File.Open(path))
+        return false;
+
+    const auto& header = m_File.Header();
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        const auto& level = header.levels[i];
+        m_Levels.push_back({ (int)level.width, (int)level.height,
+            (int)level.columns, (int)level.rows, level.firstTile });
+    }
+    m_Size = glm::ivec2(header.width, header.height);
+    m_TileSize = (int)header.tileSize;
+    m_Border = (int)header.border;
+    m_TileTexSize = glm::vec2((float)(header.tileSize + 2 * header.border));
+    m_TopTexture = CreateTileTexture(m_File.Tile(header.levelCount - 1, 0, 0));
+    return true;
+}
+
+void MapTiles::SetTexture(GLuint texture, const glm::ivec2& size) {
+    Cleanup();
+    m_Levels.push_back({ size.x, size.y, 1, 1, 0 });
+    m_Size = size;
+    m_TileSize = std::max(size.x, size.y);
+    m_Border = 0;
+    m_TileTexSize = glm::vec2(size);
+    m_TopTexture = texture;
+}
+
+void MapTiles::Cleanup() {
+    for (auto& [key, tile] : m_Tiles) {
+        glDeleteTextures(1, &tile.texture);
+    }
+    m_Tiles.clear();
+    m_LRU.clear();
+    m_Bytes = 0;
+    if (m_TopTexture != 0) {
+        glDeleteTextures(1, &m_TopTexture);
+        m_TopTexture = 0;
+    }
+    m_Levels.clear();
+    m_Size = glm::ivec2(0);
+    m_File.Close();
+}
+
+glm::vec4 MapTiles::TileRect(int level, int x, int y) const {
+    const auto& info = m_Levels[level];
+    glm::vec2 scale = glm::vec2(m_Size) / glm::vec2(info.width, info.height);
+    glm::vec2 p0(x * m_TileSize, y * m_TileSize);
+    glm::vec2 p1(std::min((x + 1) * m_TileSize, info.width),
+        std::min((y + 1) * m_TileSize, info.height));
+    return glm::vec4(-glm::vec2(m_Size) / 2.f + p0 * scale, (p1 - p0) * scale);
+}
+
+glm::vec4 MapTiles::TileUV(int level, int x, int y, const glm::vec4& rect) const {
+    // rect 换算到该瓦片内的层级像素，再跳过边框
+    const auto& info = m_Levels[level];
+    glm::vec2 scale = glm::vec2(info.width, info.height) / glm::vec2(m_Size);
+    glm::vec4 tile = TileRect(level, x, y);
+    glm::vec2 local = (glm::vec2(rect) - glm::vec2(tile)) * scale;
+    glm::vec2 size = glm::vec2(rect.z, rect.w) * scale;
+    return glm::vec4((local + (float)m_Border) / m_TileTexSize, size / m_TileTexSize);
+}
+
+GLuint MapTiles::Find(int level, int x, int y) {
+    if (level == (int)m_Levels.size() - 1)
+        return m_TopTexture;
+    const auto& info = m_Levels[level];
+    auto itr = m_Tiles.find(info.firstTile + y * info.columns + x);
+    if (itr == m_Tiles.end())
+        return 0;
+    auto& tile = itr->second;
+    tile.frame = m_Frame;
+    m_LRU.splice(m_LRU.begin(), m_LRU, tile.lru);
+    return tile.texture;
+}
+
+GLuint MapTiles::CreateTileTexture(const unsigned char* pixels) const {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)m_TileTexSize.x, (GLsizei)m_TileTexSize.y, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return texture;
+}
+
+GLuint MapTiles::Upload(int level, int x, int y) {
+    PROFILE_SCOPE("UploadTile");
+    size_t bytes = m_File.TileBytes();
+    // 超出预算时淘汰本帧未用到的最久未用瓦片，所有瓦片同尺寸，直接复用其纹理
+    GLuint texture = 0;
+    while (m_Bytes + bytes > m_Budget && !m_LRU.empty()) {
+        auto itr = m_Tiles.find(m_LRU.back());
+        if (itr->second.frame == m_Frame)
+            break;
+        if (texture != 0)
+            glDeleteTextures(1, &texture);
+        texture = itr->second.texture;
+        m_Tiles.erase(itr);
+        m_LRU.pop_back();
+        m_Bytes -= bytes;
+    }
+    if (m_Bytes + bytes > m_Budget) {
+        if (texture != 0)
+            glDeleteTextures(1, &texture);
+        return 0;
+    }
+
+    const unsigned char* pixels = m_File.Tile(level, x, y);
+    if (texture != 0) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)m_TileTexSize.x, (GLsizei)m_TileTexSize.y,
+            GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    else {
+        texture = CreateTileTexture(pixels);
+    }
+    m_Bytes += bytes;
+
+    const auto& info = m_Levels[level];
+    uint32_t key = info.firstTile + y * info.columns + x;
+    m_LRU.push_front(key);
+    m_Tiles.emplace(key, Tile{ texture, m_Frame, m_LRU.begin() });
+    return texture;
+}
+
+bool MapTiles::Update(const glm::vec2& lb, const glm::vec2& rt, float texelScale, std::vector<DrawItem>& items) {
+    m_Frame++;
+    if (m_Levels.empty())
+        return false;
+
+    // 选择不低于屏幕分辨率的最粗一层
+    int top = (int)m_Levels.size() - 1;
+    int level = texelScale > 1.f ? (int)std::floor(std::log2(texelScale)) : 0;
+    level = std::clamp(level, 0, top);
+
+    const auto& info = m_Levels[level];
+    glm::vec2 scale = glm::vec2(info.width, info.height) / glm::vec2(m_Size);
+    glm::vec2 p0 = (lb + glm::vec2(m_Size) / 2.f) * scale;
+    glm::vec2 p1 = (rt + glm::vec2(m_Size) / 2.f) * scale;
+    if (p1.x <= 0 || p1.y <= 0 || p0.x >= info.width || p0.y >= info.height)
+        return false;
+    int x0 = std::clamp((int)std::floor(p0.x / m_TileSize), 0, info.columns - 1);
+    int y0 = std::clamp((int)std::floor(p0.y / m_TileSize), 0, info.rows - 1);
+    int x1 = std::clamp((int)std::floor(p1.x / m_TileSize), 0, info.columns - 1);
+    int y1 = std::clamp((int)std::floor(p1.y / m_TileSize), 0, info.rows - 1);
+
+    int uploads = 0;
+    bool pending = false;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            GLuint texture = Find(level, x, y);
+            if (texture == 0) {
+                if (uploads < MAX_UPLOADS_PER_FRAME) {
+                    texture = Upload(level, x, y);
+                    uploads++;
+                }
+                else {
+                    pending = true;
+                }
+            }
+
+            // 缺失时逐层向上找已驻留的瓦片，顶层总是存在
+            int source = level, sx = x, sy = y;
+            while (texture == 0 && source < top) {
+                source++;
+                sx = std::min(sx / 2, m_Levels[source].columns - 1);
+                sy = std::min(sy / 2, m_Levels[source].rows - 1);
+                texture = Find(source, sx, sy);
+            }
+
+            glm::vec4 rect = TileRect(level, x, y);
+            items.push_back({ texture, rect, TileUV(source, sx, sy, rect) });
+        }
+    }
+    return pending;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifdef WIN32
+#include <glad/glad.h>
+#elif defined(__EMSCRIPTEN__)
+#include <GLES3/gl3.h>
+#endif
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TextureFile.h"
+
+// 地图瓦片金字塔的流式加载：按每屏幕像素对应的地图像素数选择层级，只上传可见的瓦片。
+// GPU 上的瓦片按最近使用淘汰，总字节数不超过预算；顶层瓦片常驻，不计入预算。
+// 尚未上传的瓦片以已驻留的最近上层瓦片的对应区域代替。
+// 坐标以地图中心为原点且 y 轴向上，与 MapViewer 的绘制坐标一致
+class MapTiles {
+public:
+    struct DrawItem {
+        GLuint texture;
+        glm::vec4 rect; // 地图坐标中的左下角与尺寸
+        glm::vec4 uv;   // 纹理坐标的偏移与尺寸
+    };
+
+    void SetBudget(size_t bytes) {
+        m_Budget = bytes;
+    }
+    // 打开 .emtiles 并上传顶层瓦片
+    bool Open(const char* path);
+    // 没有瓦片金字塔时整张纹理作为唯一的一块瓦片，接管 texture 的所有权
+    void SetTexture(GLuint texture, const glm::ivec2& size);
+    void Cleanup();
+
+    const glm::ivec2& Size() const {
+        return m_Size;
+    }
+    size_t ResidentBytes() const {
+        return m_Bytes;
+    }
+    size_t ResidentTiles() const {
+        return m_Tiles.size();
+    }
+
+    // 选出覆盖 [lb, rt] 的瓦片并上传其中缺失的部分，texelScale 为每个屏幕像素对应的地图像素数。
+    // 返回是否还有瓦片留待之后的帧上传
+    bool Update(const glm::vec2& lb, const glm::vec2& rt, float texelScale, std::vector<DrawItem>& items);
+
+private:
+    struct Level {
+        int width;
+        int height;
+        int columns;
+        int rows;
+        uint32_t firstTile;
+    };
+    struct Tile {
+        GLuint texture;
+        uint64_t frame; // 最近一次使用的帧
+        std::list<uint32_t>::iterator lru;
+    };
+
+    glm::vec4 TileRect(int level, int x, int y) const;
+    glm::vec4 TileUV(int level, int x, int y, const glm::vec4& rect) const;
+    // 已驻留的瓦片纹理，不存在时返回 0
+    GLuint Find(int level, int x, int y);
+    GLuint Upload(int level, int x, int y);
+    GLuint CreateTileTexture(const unsigned char* pixels) const;
+
+private:
+    // 每帧最多上传的瓦片数，避免缩放或平移时单帧卡顿
+    static constexpr int MAX_UPLOADS_PER_FRAME = 4;
+
+    TileFile m_File;
+    std::vector<Level> m_Levels;
+    glm::ivec2 m_Size{};
+    int m_TileSize = 0;
+    int m_Border = 0;
+    glm::vec2 m_TileTexSize{};
+    GLuint m_TopTexture = 0;
+
+    std::unordered_map<uint32_t, Tile> m_Tiles;
+    std::list<uint32_t> m_LRU; // 头部为最近使用
+    size_t m_Budget = 64 << 20;
+    size_t m_Bytes = 0;
+    uint64_t m_Frame = 0;
+};
@@ -1,9 +1,31 @@
 #include "MapViewer.h"
+#include <cstddef>
 #include <string>
 #include <imgui.h>
-#include "GLUtils.h"
+
+#include "Profiler.h"
 
 static constexpr glm::vec2 ZOOM_RANGE(1, 5);
+// map.vert、icon.vert 与 route.vert 中 Frame uniform block 的绑定点
+static constexpr GLuint FRAME_BINDING = 0;
+// 图标网格的格子边长（地图像素），与常见图标尺寸相当
+static constexpr float ICON_GRID_CELL = 64.f;
+// 地图瓦片占用显存的上限，浏览器中可分配的纹理内存更少
+#ifdef __EMSCRIPTEN__
+static constexpr size_t MAP_TILE_BUDGET = 24 << 20;
+#else
+static constexpr size_t MAP_TILE_BUDGET = 64 << 20;
+#endif
+// 路线线宽（屏幕像素）与预乘 alpha 的颜色
+static constexpr float ROUTE_WIDTH = 4.f;
+static constexpr glm::vec4 ROUTE_COLOR(0.9f, 0.75f, 0.2f, 0.9f);
+// 锐角拐角处斜接长度的上限（线宽一半的倍数），超出时截断
+static constexpr float ROUTE_MITER_LIMIT = 4.f;
+
+float MapViewer::IconRadius(uint32_t slot) const {
+    const auto& kind = m_IconKinds[m_Icons.Kind(slot)];
+    return glm::max(kind.size.x, kind.size.y) / 2 * 1.4142f * m_Icons.Scale(slot);
+}
 
 void MapViewer::InitMapPipeline() {
     float vertices[] = {
@@ -34,16 +56,10 @@ void MapViewer::InitMapPipeline() {
 
     glBindVertexArray(0);
 
-    GLuint vs = CompileShaderFile(GL_VERTEX_SHADER, DATA_DIR("map.vert").c_str());
-    GLuint fs = CompileShaderFile(GL_FRAGMENT_SHADER, DATA_DIR("map.frag").c_str());
-
-    m_MapPipeline = glCreateProgram();
-    glAttachShader(m_MapPipeline, vs);
-    glAttachShader(m_MapPipeline, fs);
-    glLinkProgram(m_MapPipeline);
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    m_MapPipeline.Load(DATA_DIR("map.vert").c_str(), DATA_DIR("map.frag").c_str());
+    m_MapPipeline.BindBlock("Frame", FRAME_BINDING);
+    m_MapModelLoc = m_MapPipeline.Uniform("model");
+    m_MapTexRectLoc = m_MapPipeline.Uniform("texRect");
 
     glDeleteBuffers(1, &mapVBO);
     glDeleteBuffers(1, &mapEBO);
@@ -64,6 +80,7 @@ void MapViewer::InitIconPipeline() {
     glGenVertexArrays(1, &m_IconVAO);
     glGenBuffers(1, &iconVBO);
     glGenBuffers(1, &iconEBO);
+    glGenBuffers(1, &m_IconInstanceVBO);
 
     glBindVertexArray(m_IconVAO);
 
@@ -76,80 +93,230 @@ void MapViewer::InitIconPipeline() {
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
-
-    GLuint vs = CompileShaderFile(GL_VERTEX_SHADER, DATA_DIR("icon.vert").c_str());
-    GLuint fs = CompileShaderFile(GL_FRAGMENT_SHADER, DATA_DIR("icon.frag").c_str());
+    // 每个图标一个实例：中心、尺寸与图集矩形
+    glBindBuffer(GL_ARRAY_BUFFER, m_IconInstanceVBO);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(IconInstance),
+        (void*)offsetof(IconInstance, center));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(IconInstance),
+        (void*)offsetof(IconInstance, size));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(IconInstance),
+        (void*)offsetof(IconInstance, rect));
+    for (GLuint attr = 1; attr <= 3; attr++) {
+        glEnableVertexAttribArray(attr);
+        glVertexAttribDivisor(attr, 1);
+    }
 
-    m_IconPipeline = glCreateProgram();
-    glAttachShader(m_IconPipeline, vs);
-    glAttachShader(m_IconPipeline, fs);
-    glLinkProgram(m_IconPipeline);
+    glBindVertexArray(0);
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    m_IconPipeline.Load(DATA_DIR("icon.vert").c_str(), DATA_DIR("icon.frag").c_str());
+    m_IconPipeline.BindBlock("Frame", FRAME_BINDING);
 
     glDeleteBuffers(1, &iconVBO);
     glDeleteBuffers(1, &iconEBO);
 }
 
-void MapViewer::DrawMap(const glm::mat4& vpMat) {
-    glUseProgram(m_MapPipeline);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void MapViewer::InitRoutePipeline() {
+    glGenVertexArrays(1, &m_RouteVAO);
+    glGenBuffers(1, &m_RouteVBO);
 
-    glm::mat4 modelMatrix = glm::mat4(1.f);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(m_MapSize, 1.f));
+    glBindVertexArray(m_RouteVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_RouteVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RouteVertex),
+        (void*)offsetof(RouteVertex, pos));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(RouteVertex),
+        (void*)offsetof(RouteVertex, normal));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
 
-    glm::mat4 mvpMatrix = vpMat * modelMatrix;
-    GLint mvpLoc = glGetUniformLocation(m_MapPipeline, "mvp");
-    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvpMatrix));
+    m_RoutePipeline.Load(DATA_DIR("route.vert").c_str(), DATA_DIR("route.frag").c_str());
+    m_RoutePipeline.BindBlock("Frame", FRAME_BINDING);
+    m_RouteHalfWidthLoc = m_RoutePipeline.Uniform("halfWidth");
+    m_RouteColorLoc = m_RoutePipeline.Uniform("color");
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_MapTexture);
+void MapViewer::DrawMap(const glm::vec2& lb, const glm::vec2& rt) {
+    // 每个屏幕像素对应的地图像素数决定瓦片层级
+    float texelScale = m_Viewport.z > 0 ? (rt.x - lb.x) / m_Viewport.z : 1.f;
+    m_MapDraws.clear();
+    // 尚有瓦片未上传时继续重绘，直到可见区域全部就绪
+    if (m_MapTiles.Update(lb, rt, texelScale, m_MapDraws))
+        m_Changed = true;
+
+    m_MapPipeline.Use();
+    // 纹理为预乘 alpha
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
+    glActiveTexture(GL_TEXTURE0);
     glBindVertexArray(m_MapVAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    for (const auto& draw : m_MapDraws) {
+        glm::vec2 size(draw.rect.z, draw.rect.w);
+        glm::mat4 modelMatrix = glm::translate(glm::mat4(1.f), glm::vec3(glm::vec2(draw.rect) + size / 2.f, 0.f));
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(size, 1.f));
+        glUniformMatrix4fv(m_MapModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+        glUniform4fv(m_MapTexRectLoc, 1, glm::value_ptr(draw.uv));
+
+        glBindTexture(GL_TEXTURE_2D, draw.texture);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
 
     glBindVertexArray(0);
 }
 
-void MapViewer::DrawIcon(const glm::mat4& vpMat, const MapButton& btn) {
-    if (!btn.rect) return;
+void MapViewer::RebuildIconGrid() {
+    m_IconGrid.Reset(m_MapSize, ICON_GRID_CELL);
+    for (uint32_t slot = 0; slot < m_Icons.Capacity(); slot++) {
+        if (m_Icons.LayerMask(slot) != 0)
+            m_IconGrid.Insert(slot, m_Icons.Pos(slot));
+    }
+}
 
-    glUseProgram(m_IconPipeline);
-    glBlendFunc(GL_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void MapViewer::UpdateIcons() {
+    // 按列遍历种类与缩放，空闲槽位的缩放不影响结果
+    float kindRadius[eIconKindCount];
+    for (int i = 0; i < eIconKindCount; i++) {
+        const auto& kind = m_IconKinds[i];
+        kindRadius[i] = kind.valid ? glm::max(kind.size.x, kind.size.y) / 2 * 1.4142f : 0.f;
+    }
+    const auto& kinds = m_Icons.Kinds();
+    const auto& scales = m_Icons.Scales();
+    m_IconExtent = 0;
+    for (size_t slot = 0; slot < kinds.size(); slot++) {
+        m_IconExtent = glm::max(m_IconExtent, kindRadius[kinds[slot]] * scales[slot]);
+    }
+    m_IconsDirty = false;
+}
 
-    glm::vec2 size(btn.rect->z, btn.rect->w);
-    glm::mat4 modelMat = glm::mat4(1.f);
-    glm::vec2 m02c = glm::vec2(btn.pos) - glm::vec2(m_MapSize) / 2.f;
-    modelMat = glm::translate(modelMat, glm::vec3(m02c.x, -m02c.y, 0.f));
-    modelMat = glm::scale(modelMat, glm::vec3(size * btn.scale, 1.f));
-    
-    glm::mat4 mvpMatrix = vpMat * modelMat;
-    GLint mvpLoc = glGetUniformLocation(m_IconPipeline, "mvp");
-    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvpMatrix));
+void MapViewer::UpdateIconInstances(const glm::vec4& view) {
+    PROFILE_SCOPE("UpdateIconInstances");
+    glm::vec2 min = glm::vec2(view.x, view.y) - m_IconExtent;
+    glm::vec2 max = glm::vec2(view.z, view.w) + m_IconExtent;
+
+    m_IconQuery.clear();
+    m_IconGrid.Query(min, max, [this](uint32_t slot) {
+        m_IconQuery.push_back(slot);
+    });
+    std::sort(m_IconQuery.begin(), m_IconQuery.end(),
+        [this](uint32_t l, uint32_t r) {
+            return IconOrder(l) < IconOrder(r);
+        });
+
+    m_IconInstances.clear();
+    for (uint32_t slot : m_IconQuery) {
+        const auto& kind = m_IconKinds[m_Icons.Kind(slot)];
+        if (!kind.valid || 0 == (m_IconFlags & m_Icons.LayerMask(slot)))
+            continue;
+        const auto& pos = m_Icons.Pos(slot);
+        if (glm::any(glm::lessThan(pos, min)) || glm::any(glm::greaterThan(pos, max)))
+            continue;
 
-    glm::vec2 texOffset(btn.rect->x, btn.rect->y);
-    texOffset /= m_IconsSize;
-    glm::vec2 texSize(size);
-    texSize /= m_IconsSize;
+        glm::vec2 m02c = pos - glm::vec2(m_MapSize) / 2.f;
+        IconInstance instance;
+        instance.center = glm::vec2(m02c.x, -m02c.y);
+        instance.size = kind.size * m_Icons.Scale(slot);
+        instance.rect = kind.rect;
+        m_IconInstances.push_back(instance);
+    }
 
-    texOffset.y = 1 - texOffset.y - texSize.y;
-    GLint offsetLoc = glGetUniformLocation(m_IconPipeline, "offset");
-    glUniform2fv(offsetLoc, 1, glm::value_ptr(texOffset));
+    glBindBuffer(GL_ARRAY_BUFFER, m_IconInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_IconInstances.size() * sizeof(IconInstance),
+        m_IconInstances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_IconView = view;
+}
 
-    GLint sizeLoc = glGetUniformLocation(m_IconPipeline, "size");
-    glUniform2fv(sizeLoc, 1, glm::value_ptr(texSize));
+void MapViewer::DrawIcons() {
+    // 只提交视口内的图标，视口或图标变化时重建实例数据
+    glm::vec4 view = GetViewRect();
+    bool rebuild = m_IconsDirty || view != m_IconView;
+    if (m_IconsDirty)
+        UpdateIcons();
+    if (rebuild)
+        UpdateIconInstances(view);
+    if (m_IconInstances.empty())
+        return;
+
+    m_IconPipeline.Use();
+    glBlendFunc(GL_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_IconsTexture);
 
     glBindVertexArray(m_IconVAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0,
+        (GLsizei)m_IconInstances.size());
 
     glBindVertexArray(0);
 }
 
+void MapViewer::SetRoute(const std::vector<glm::vec2>& points) {
+    if (points == m_Route)
+        return;
+    m_Route = points;
+    m_RouteDirty = true;
+    m_Changed = true;
+}
+
+void MapViewer::UpdateRouteVertices() {
+    // 三角形带：每个顶点沿两侧法向各展开一个顶点，拐角处取两段法向的斜接方向
+    m_RouteVertices.clear();
+    std::vector<glm::vec2> points;
+    for (const auto& pos : m_Route) {
+        glm::vec2 m02c = pos - glm::vec2(m_MapSize) / 2.f;
+        glm::vec2 center(m02c.x, -m02c.y);
+        if (points.empty() || center != points.back())
+            points.push_back(center);
+    }
+    if (points.size() >= 2) {
+        auto normal = [&points](size_t i) {
+            glm::vec2 dir = glm::normalize(points[i + 1] - points[i]);
+            return glm::vec2(-dir.y, dir.x);
+        };
+        for (size_t i = 0; i < points.size(); i++) {
+            glm::vec2 n;
+            if (i == 0) {
+                n = normal(0);
+            }
+            else if (i + 1 == points.size()) {
+                n = normal(i - 1);
+            }
+            else {
+                glm::vec2 n0 = normal(i - 1), n1 = normal(i);
+                glm::vec2 miter = n0 + n1;
+                float len = glm::length(miter);
+                // 折返时两段法向相反，退化为当前段的法向
+                n = len > 1e-4f ? miter / len : n1;
+                float cosine = glm::dot(n, n1);
+                n /= glm::max(cosine, 1.f / ROUTE_MITER_LIMIT);
+            }
+            m_RouteVertices.push_back({ points[i], n });
+            m_RouteVertices.push_back({ points[i], -n });
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_RouteVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_RouteVertices.size() * sizeof(RouteVertex),
+        m_RouteVertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_RouteDirty = false;
+}
+
+void MapViewer::DrawRoute(float texelScale) {
+    if (m_RouteDirty)
+        UpdateRouteVertices();
+    if (m_RouteVertices.empty())
+        return;
+
+    m_RoutePipeline.Use();
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glUniform1f(m_RouteHalfWidthLoc, ROUTE_WIDTH / 2 * texelScale);
+    glUniform4fv(m_RouteColorLoc, 1, glm::value_ptr(ROUTE_COLOR));
+
+    glBindVertexArray(m_RouteVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)m_RouteVertices.size());
+    glBindVertexArray(0);
+}
+
 glm::vec2 MapViewer::GetViewSize() const {
     return m_OriginViewSize / m_Transform.zoom;;
 }
@@ -172,6 +339,12 @@ glm::vec2 MapViewer::Screen2Map(const glm::vec2& pos) const {
     return vc2c - vc2mc + glm::vec2(m_MapSize) / 2.f;
 }
 
+glm::vec4 MapViewer::GetViewRect() const {
+    glm::vec2 p0 = Screen2Map(glm::vec2(m_Viewport.x, m_Viewport.y));
+    glm::vec2 p1 = Screen2Map(glm::vec2(m_Viewport.x + m_Viewport.z, m_Viewport.y + m_Viewport.w));
+    return glm::vec4(glm::min(p0, p1), glm::max(p0, p1));
+}
+
 void MapViewer::OnResizeMap() {
     float vaspect = 1.f * m_Viewport.z / m_Viewport.w;
     float maspect = 1.f * m_MapSize.x / m_MapSize.y;
@@ -183,29 +356,67 @@ void MapViewer::OnResizeMap() {
         m_OriginViewSize.y /= aspect;
 }
 
-void MapViewer::Initialize() {
+void MapViewer::Initialize(TextureLoader::Notify&& notify) {
+    m_Loader.Initialize(std::move(notify));
+
+    glGenBuffers(1, &m_FrameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, m_FrameUBO);
+
     InitMapPipeline();
     InitIconPipeline();
+    InitRoutePipeline();
 
     m_IconsTexture = LoadTexture(
         TEX_DIR("icons.png").c_str(),
         m_IconsSize.x, m_IconsSize.y, true);
     m_Atlas.Initialize();
+    for (int i = 0; i < eIconKindCount; i++) {
+        auto rect = m_Atlas.QueryIcon((IconKind)i);
+        if (!rect)
+            continue;
+        auto& kind = m_IconKinds[i];
+        kind.valid = true;
+        kind.size = glm::vec2(rect->z, rect->w);
+        glm::vec2 texOffset = glm::vec2(rect->x, rect->y) / glm::vec2(m_IconsSize);
+        glm::vec2 texSize = kind.size / glm::vec2(m_IconsSize);
+        texOffset.y = 1 - texOffset.y - texSize.y;
+        kind.rect = glm::vec4(texOffset, texSize);
+    }
 
-    ReloadMap("bg");
+    // 首张地图同步加载，避免启动时出现空白画面
+    m_MapTiles.SetBudget(MAP_TILE_BUDGET);
+    if (!OpenMapTiles("bg")) {
+        glm::ivec2 mapSize;
+        GLuint mapTexture = LoadTexture(TEX_DIR("bg.png").c_str(), mapSize.x, mapSize.y, true);
+        SetMapTexture(mapTexture, mapSize);
+    }
 
     vReset();
 }
 
 void MapViewer::Cleanup() {
+    m_Loader.Cleanup();
+    m_MapTiles.Cleanup();
+
     glDeleteVertexArrays(1, &m_MapVAO);
-    glDeleteProgram(m_MapPipeline);
+    m_MapPipeline.Cleanup();
 
     glDeleteVertexArrays(1, &m_IconVAO);
-    glDeleteProgram(m_IconPipeline);
+    glDeleteBuffers(1, &m_IconInstanceVBO);
+    m_IconPipeline.Cleanup();
+
+    glDeleteVertexArrays(1, &m_RouteVAO);
+    glDeleteBuffers(1, &m_RouteVBO);
+    m_RoutePipeline.Cleanup();
+
+    glDeleteBuffers(1, &m_FrameUBO);
 }
 
 void MapViewer::Render() {
+    PROFILE_SCOPE("MapViewer::Render");
     glm::vec2 viewSize = GetViewSize();
     glm::vec2 offset = m_Transform.offset;
     offset.x = -offset.x;
@@ -223,23 +434,15 @@ void MapViewer::Render() {
         glm::vec3(0, 0, 0),
         glm::vec3(0, 1, 0));
 
+    // 各管线共享的每帧数据，每帧只上传一次
     auto vpMat = projMatrix * viewMatrix;
-    DrawMap(vpMat);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(vpMat));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-    auto itr = std::remove_if(m_IconList.begin(), m_IconList.end(),
-        [](const MapButton& btn) {
-            return btn.layer < 0;
-        }
-    );
-    m_IconList.erase(itr, m_IconList.end());
-    for (auto& info : m_IconList) {
-        if (!info.rect)
-            info.rect = m_Atlas.QueryIcon(info.name.c_str());
-        if (0 == (m_IconFlags & info.layer))
-            continue;
-
-        DrawIcon(vpMat, info);
-    }
+    DrawMap(lb, rt);
+    DrawRoute(m_Viewport.z > 0 ? (rt.x - lb.x) / m_Viewport.z : 1.f);
+    DrawIcons();
 }
 
 void MapViewer::RenderImGui() {
@@ -249,6 +452,8 @@ void MapViewer::RenderImGui() {
     auto& view = m_Transform;
     ImGui::SliderFloat("缩放", &view.zoom, ZOOM_RANGE.x, ZOOM_RANGE.y);
     ImGui::DragFloat2("偏移", glm::value_ptr(view.offset), 2);
+    ImGui::Text("地图瓦片 : %d (%.1f MB)", (int)m_MapTiles.ResidentTiles(),
+        m_MapTiles.ResidentBytes() / (1024.f * 1024.f));
 }
 
 void MapViewer::Constrain() {
@@ -260,21 +465,41 @@ void MapViewer::Constrain() {
     m_Transform.offset = glm::clamp(m_Transform.offset, -range, range);
 }
 
-void MapViewer::OnClick(MapFilter* filter, int x, int y)  const {
+bool MapViewer::Pick(int x, int y, uint32_t layers, uint32_t& hit) const {
     auto mapPos = Screen2Map(glm::vec2(x, y));
-    for (auto& btn : m_IconList) {
-        if (!btn.rect) continue;
-        if (btn.layer < 0) continue;
-        if (!btn.onclick) continue;
-        if (0 == (btn.layer & m_IconFlags))
-            continue;
-
-        float dis = glm::distance(mapPos, btn.pos);
-        float range = glm::max(btn.rect->z, btn.rect->w) / 2;
-        if (dis <= range * 1.4142f * btn.scale) {
-            btn.onclick(filter, btn.userdata);
+    // 只检查点击半径内的格子，取 layers 中绘制在最上层的一个
+    bool found = false;
+    m_IconGrid.Query(mapPos - m_IconExtent, mapPos + m_IconExtent, [&](uint32_t slot) {
+        uint32_t mask = m_Icons.LayerMask(slot);
+        if (0 == (mask & m_IconFlags & layers))
+            return;
+        if (!m_IconKinds[m_Icons.Kind(slot)].valid)
+            return;
+        if (found && IconOrder(slot) < IconOrder(hit))
+            return;
+        if (glm::distance(mapPos, m_Icons.Pos(slot)) <= IconRadius(slot)) {
+            hit = slot;
+            found = true;
         }
-    }
+    });
+    return found;
+}
+
+void MapViewer::OnClick(MapFilter* filter, int x, int y)  const {
+    uint32_t hit = 0;
+    if (!Pick(x, y, m_ClickableLayers, hit))
+        return;
+
+    int layer = IconStore::LayerOf(m_Icons.LayerMask(hit));
+    m_LayerCallbacks[layer](filter, m_Icons.UserData(hit));
+}
+
+bool MapViewer::PickIcon(int x, int y, int layer, uint32_t& userdata) const {
+    uint32_t hit = 0;
+    if (!Pick(x, y, 1u << layer, hit))
+        return false;
+    userdata = m_Icons.UserData(hit);
+    return true;
 }
 
 void MapViewer::SetViewport(const glm::ivec4& viewport) {
@@ -284,27 +509,60 @@ void MapViewer::SetViewport(const glm::ivec4& viewport) {
 }
 
 void MapViewer::ReloadMap(const char* mapName_) {
-    if (m_MapTexture != 0) {
-        glDeleteTextures(1, &m_MapTexture);
-        m_MapTexture = 0;
-    }
-    m_MapTexture = LoadTexture(
-        TEX_DIR(std::string(mapName_) + ".png").c_str(),
-        m_MapSize.x, m_MapSize.y, true);
+    // 旧地图保留到新纹理上传完成，连续切换时只应用最后一次请求
+    uint32_t request = ++m_MapRequest;
+    // 瓦片金字塔只需映射文件并上传顶层瓦片，直接切换
+    if (OpenMapTiles(mapName_))
+        return;
+    m_Loader.Load(TEX_DIR(std::string(mapName_) + ".png").c_str(), true,
+        [this, request](GLuint texture, int width, int height) {
+            if (request != m_MapRequest || texture == 0) {
+                glDeleteTextures(1, &texture);
+                return;
+            }
+            SetMapTexture(texture, glm::ivec2(width, height));
+        });
+}
+
+void MapViewer::SetMapTexture(GLuint texture, const glm::ivec2& size) {
+    m_MapTiles.SetTexture(texture, size);
+    OnMapChanged();
+}
+
+bool MapViewer::OpenMapTiles(const char* mapName) {
+    if (!m_MapTiles.Open(TEX_DIR(std::string(mapName) + ".emtiles").c_str()))
+        return false;
+    OnMapChanged();
+    return true;
+}
+
+void MapViewer::OnMapChanged() {
+    m_MapSize = m_MapTiles.Size();
+    // 图标实例坐标以地图中心为原点，网格范围随地图尺寸变化
+    m_IconsDirty = true;
+    RebuildIconGrid();
+    m_RouteDirty = true;
     vReset();
     OnResizeMap();
 }
 
+void MapViewer::Update() {
+    m_Loader.Poll();
+}
+
 void MapViewer::vZoom(float value) {
+    m_Changed = true;
     m_Transform.zoom += value;
 }
 
 void MapViewer::vMove(int x, int y) {
+    m_Changed = true;
     glm::vec2 offset(x, y);
     m_Transform.offset += Normalize(offset);
 }
 
 void MapViewer::vReset() {
+    m_Changed = true;
     m_Transform.zoom = 1.f;
     m_Transform.offset = glm::vec2(0, 0);
 }
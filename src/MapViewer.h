@@ -13,59 +13,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "AssetUtils.h"
+#include "GLUtils.h"
+#include "IconGrid.h"
+#include "IconStore.h"
+#include "MapTiles.h"
 
 class MapFilter;
-using Callback = std::function<void(MapFilter*, void*)>;
-
-class MapButton {
-    friend class MapViewer;
-public:
-    MapButton(glm::vec2 pos_, const char* name_, int layer_) {
-        pos = pos_;
-        name = name_;
-        SetLayer(layer_);
-    }
-    MapButton& SetScale(float value) {
-        scale = value;
-        return *this;
-    }
-    MapButton& SetCallback(Callback&& func) {
-        onclick = func;
-        return *this;
-    }
-    MapButton& SetUserData(void* ud) {
-        userdata = ud;
-        return *this;
-    }
-    MapButton& SetText(const std::string& str) {
-        text = str;
-        return *this;
-    }
-    MapButton& SetLayer(int value) {
-        layer = 1 << value;
-        return *this;
-    }
-    void Delete() {
-        layer = -1;
-    }
-    std::string_view Name() const {
-        return name;
-    }
-    const void* UserData() const {
-        return userdata;
-    }
-
-private:
-    glm::vec2 pos{ 0,0 };
-    std::string name;
-    const glm::ivec4* rect = nullptr;
-
-    float scale = 1;
-    std::string text;
-    int layer = -1;
-    void* userdata = nullptr;
-    Callback onclick;
-};
+// 点击图标时按所在层回调，userdata 为添加图标时传入的值
+using Callback = std::function<void(MapFilter*, uint32_t userdata)>;
 
 class MapViewer {
 public:
@@ -75,70 +30,188 @@ public:
     };
 
 private:
-    GLuint m_MapPipeline = 0;
+    // 图标实例数据，center 以地图中心为原点且 y 轴向上
+    struct IconInstance {
+        glm::vec2 center;
+        glm::vec2 size;
+        glm::vec4 rect; // 图集内纹理坐标的偏移与尺寸
+    };
+    // 路线折线的顶点，pos 与 IconInstance::center 同一坐标系
+    struct RouteVertex {
+        glm::vec2 pos;
+        glm::vec2 normal;
+    };
+
+    GLuint m_FrameUBO = 0;
+
+    ShaderProgram m_MapPipeline;
+    GLint m_MapModelLoc = -1;
+    GLint m_MapTexRectLoc = -1;
     GLuint m_MapVAO = 0;
 
-    GLuint m_IconPipeline = 0;
+    ShaderProgram m_IconPipeline;
     GLuint m_IconVAO = 0;
+    GLuint m_IconInstanceVBO = 0;
+
+    ShaderProgram m_RoutePipeline;
+    GLint m_RouteHalfWidthLoc = -1;
+    GLint m_RouteColorLoc = -1;
+    GLuint m_RouteVAO = 0;
+    GLuint m_RouteVBO = 0;
 
-    GLuint m_MapTexture = 0;
+    MapTiles m_MapTiles;
+    std::vector<MapTiles::DrawItem> m_MapDraws;
     glm::ivec2 m_MapSize{};
+    TextureLoader m_Loader;
+    uint32_t m_MapRequest = 0;
 
     GLuint m_IconsTexture = 0;
     glm::ivec2 m_IconsSize;
+    // 各图标种类的尺寸与图集纹理坐标，图集加载后解析一次
+    struct IconKindInfo {
+        bool valid = false;
+        glm::vec2 size{};
+        glm::vec4 rect{};
+    };
+    IconKindInfo m_IconKinds[eIconKindCount];
 
     Transform m_Transform;
     glm::ivec4 m_Viewport{};
     glm::vec2 m_OriginViewSize{};
 
     IconAtlas m_Atlas;
-    std::vector<MapButton> m_IconList;
+    IconStore m_Icons;
+    Callback m_LayerCallbacks[IconStore::MAX_LAYERS];
+    uint32_t m_ClickableLayers = 0;
     int m_IconFlags = -1;
+    // 图标增删、缩放或显示层变化后置位，下一帧重新上传实例数据
+    bool m_IconsDirty = true;
+    // 按图标槽位的位置分桶，用于点击拾取与视口裁剪；增删时同步更新，换地图后整体重建
+    // 地图尺寸变化时立即重建，增删图标时同步更新，拾取无需等到下一帧
+    IconGrid m_IconGrid;
+    // 图标点击半径的最大值，也是裁剪时视口向外扩展的距离；
+    // 添加与放大图标时立即扩大，删除与缩小后在下一帧 UpdateIcons 中收紧
+    float m_IconExtent = 0;
+    // 当前实例数据对应的可见范围（地图坐标 min, max）
+    glm::vec4 m_IconView{};
+    std::vector<uint32_t> m_IconQuery;
+    std::vector<IconInstance> m_IconInstances;
+    // 路线折线（地图像素坐标）与其三角形带，路线或地图尺寸变化后下一帧重建并上传
+    std::vector<glm::vec2> m_Route;
+    std::vector<RouteVertex> m_RouteVertices;
+    bool m_RouteDirty = false;
+    // 视图变换或地图变化，需要重绘
+    bool m_Changed = true;
 
     void InitMapPipeline();
     void InitIconPipeline();
-    void DrawMap(const glm::mat4& vpMat);
-    void DrawIcon(const glm::mat4& vpMat, const MapButton& btn);
+    void InitRoutePipeline();
+    void DrawMap(const glm::vec2& lb, const glm::vec2& rt);
+    // 线宽按屏幕像素固定，texelScale 为每个屏幕像素对应的地图像素数
+    void UpdateRouteVertices();
+    void DrawRoute(float texelScale);
+    // 点击判定半径，覆盖图标的外接圆
+    float IconRadius(uint32_t slot) const;
+    void RebuildIconGrid();
+    // 绘制顺序：层号大的在上，同层中后添加的在上（槽位会复用，不能按槽位排序）
+    uint64_t IconOrder(uint32_t slot) const {
+        return (uint64_t)m_Icons.LayerMask(slot) << 32 | m_Icons.Sequence(slot);
+    }
+    // 屏幕坐标处 layers 中绘制在最上层的可见图标
+    bool Pick(int x, int y, uint32_t layers, uint32_t& hit) const;
+    void UpdateIcons();
+    void UpdateIconInstances(const glm::vec4& view);
+    void DrawIcons();
 
     glm::vec2 GetViewSize() const;
     glm::vec2 Normalize(const glm::vec2& pos) const;
     glm::vec2 Screen2Map(const glm::vec2& pos) const;
+    // 视口在地图坐标中的范围 (min, max)
+    glm::vec4 GetViewRect() const;
     void OnResizeMap();
+    void SetMapTexture(GLuint texture, const glm::ivec2& size);
+    // 优先打开地图的瓦片金字塔，缺失时返回 false
+    bool OpenMapTiles(const char* mapName);
+    void OnMapChanged();
 
 public:
-    void Initialize();
+    // notify 在加载线程中调用，通知有纹理等待上传
+    void Initialize(TextureLoader::Notify&& notify = nullptr);
     void Cleanup();
+    // 上传后台解码完成的纹理，需在渲染线程调用
+    void Update();
     void Render();
     void RenderImGui();
     void Constrain();
+    // 只触发最上层（最后绘制）的图标
     void OnClick(MapFilter* filter, int x, int y) const;
+    // 鼠标悬停等不触发回调的拾取，返回 layer 层中最上层图标的 userdata
+    bool PickIcon(int x, int y, int layer, uint32_t& userdata) const;
 
     void SetViewport(const glm::ivec4& viewport);
+    // 有瓦片金字塔时立即切换、按需流式加载瓦片；否则异步加载 png，新纹理就绪前继续显示旧地图
     void ReloadMap(const char* mapName);
-
-    void ForeachButton(std::function<void(MapButton&)>&& func) {
-        std::for_each(m_IconList.begin(), m_IconList.end(), func);
+    // 画面是否有尚未绘制的变化
+    bool HasChanged() const {
+        return m_Changed || m_IconsDirty;
     }
-    void RemoveAllButtons() {
-        ForeachButton([](MapButton& btn) { btn.Delete(); });
+    // 自上次调用以来画面是否有变化，调用后清除
+    bool ConsumeChanged() {
+        bool changed = HasChanged();
+        m_Changed = false;
+        return changed;
     }
-    void SetButtonFlagBits(int flags) {
-        m_IconFlags = flags;
+
+    IconHandle AddIcon(const glm::vec2& pos, IconKind kind, int layer, float scale = 1.f, uint32_t userdata = 0) {
+        m_IconsDirty = true;
+        IconHandle handle = m_Icons.Add(pos, kind, layer, scale, userdata);
+        uint32_t slot = IconStore::Slot(handle);
+        m_IconGrid.Insert(slot, pos);
+        m_IconExtent = glm::max(m_IconExtent, IconRadius(slot));
+        return handle;
     }
-    void RemoveAllButtons(int layer) {
-        ForeachButton([layer](MapButton& btn) {
-            int value = 1 << layer;
-            if (btn.layer == value)
-                btn.Delete(); 
+    void RemoveIcon(IconHandle handle) {
+        if (!m_Icons.IsValid(handle))
+            return;
+        m_IconsDirty = true;
+        uint32_t slot = IconStore::Slot(handle);
+        m_IconGrid.Remove(slot, m_Icons.Pos(slot));
+        m_Icons.Remove(handle);
+    }
+    void RemoveIcons(int layer) {
+        m_IconsDirty = m_IconsDirty || m_Icons.LayerCount(layer) > 0;
+        m_Icons.ForeachInLayer(layer, [this](uint32_t slot) {
+            m_IconGrid.Remove(slot, m_Icons.Pos(slot));
         });
+        m_Icons.RemoveLayer(layer);
+    }
+    void RemoveAllIcons() {
+        m_IconsDirty = true;
+        m_IconGrid.Clear();
+        m_Icons.Clear();
     }
-    MapButton& AddButton(const glm::vec2& pos, const char* name) {
-        m_IconList.emplace_back(pos, name, 0);
-        return m_IconList.back();
+    void SetIconScale(IconHandle handle, float scale) {
+        if (!m_Icons.IsValid(handle))
+            return;
+        m_IconsDirty = true;
+        m_Icons.SetScale(handle, scale);
+        m_IconExtent = glm::max(m_IconExtent, IconRadius(IconStore::Slot(handle)));
+    }
+    // 依次经过 points（地图像素坐标）的折线，绘制在地图与图标之间；为空时清除路线
+    void SetRoute(const std::vector<glm::vec2>& points);
+    void ClearRoute() {
+        SetRoute({});
+    }
+    void SetIconFlagBits(int flags) {
+        m_IconsDirty = m_IconsDirty || m_IconFlags != flags;
+        m_IconFlags = flags;
     }
-    MapButton& AddButton(const glm::vec2& pos, const char* name, int layer) {
-        m_IconList.emplace_back(pos, name, layer);
-        return m_IconList.back();
+    void SetLayerCallback(int layer, Callback&& callback) {
+        if (callback)
+            m_ClickableLayers |= 1u << layer;
+        else
+            m_ClickableLayers &= ~(1u << layer);
+        m_LayerCallbacks[layer] = std::move(callback);
     }
     
     void vZoom(float value);
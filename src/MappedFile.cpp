@@ -0,0 +1,84 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+void MappedFile::Close() {
+#if defined(_WIN32)
+    if (m_Mapping)
+        UnmapViewOfFile(m_Mapping);
+#elif !defined(__EMSCRIPTEN__)
+    if (m_Mapping)
+        munmap(m_Mapping, m_Size);
+#endif
+    m_Mapping = nullptr;
+    std::vector<char>().swap(m_Buffer);
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+bool MappedFile::Open(const char* path) {
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+    m_Mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!m_Mapping)
+        return false;
+    m_Size = (size_t)fileSize.QuadPart;
+    m_Data = static_cast<const char*>(m_Mapping);
+#elif !defined(__EMSCRIPTEN__)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st {};
+    fstat(fd, &st);
+    size_t size = (size_t)st.st_size;
+    void* mapped = size > 0
+        ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    m_Mapping = mapped;
+    m_Size = size;
+    m_Data = static_cast<const char*>(m_Mapping);
+#else
+    // 预加载的文件已在内存文件系统中，整块读出即可
+    std::ifstream ss(path, std::ios::binary);
+    if (!ss.is_open())
+        return false;
+    ss.seekg(0, std::ios::end);
+    m_Buffer.resize((size_t)ss.tellg());
+    ss.seekg(0, std::ios::beg);
+    ss.read(m_Buffer.data(), m_Buffer.size());
+    if (m_Buffer.empty())
+        return false;
+    m_Size = m_Buffer.size();
+    m_Data = m_Buffer.data();
+#endif
+    return true;
+}
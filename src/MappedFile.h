@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// 只读映射整个文件（mmap / MapViewOfFile），Emscripten 下整块读入内存文件系统中的文件
+class MappedFile {
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const {
+		return m_Data != nullptr;
+	}
+	const char* Data() const {
+		return m_Data;
+	}
+	size_t Size() const {
+		return m_Size;
+	}
+
+private:
+	const char* m_Data = nullptr;
+	size_t m_Size = 0;
+	void* m_Mapping = nullptr;
+	std::vector<char> m_Buffer;
+};
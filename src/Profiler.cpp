@@ -0,0 +1,133 @@
+#include "Profiler.h"
+#include <atomic>
+#include <fstream>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "LogUtils.h"
+
+struct OpenScope {
+    Profiler::Scope* scope;
+    uint64_t start;
+};
+
+// 每个线程独立的作用域栈，栈深即嵌套深度
+static thread_local std::vector<OpenScope> t_Stack;
+
+static uint32_t ThreadIndex() {
+    static std::atomic<uint32_t> next{ 0 };
+    thread_local uint32_t index = next++;
+    return index;
+}
+
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() {
+    m_Epoch = std::chrono::steady_clock::now();
+    m_Events.reserve(TRACE_CAPACITY);
+}
+
+uint64_t Profiler::Now() const {
+    auto elapsed = std::chrono::steady_clock::now() - m_Epoch;
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+Profiler::Scope& Profiler::FindScope(const char* name, int depth) {
+    auto itr = m_ScopeIds.find(name);
+    if (itr != m_ScopeIds.end())
+        return *itr->second;
+    auto& scope = m_Scopes.emplace_back();
+    scope.name = name;
+    scope.depth = depth;
+    m_ScopeIds.emplace(name, &scope);
+    return scope;
+}
+
+void Profiler::Begin(const char* name) {
+    Scope* scope;
+    {
+        // 开始时登记，面板中父作用域排在子作用域之前
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        scope = &FindScope(name, (int)t_Stack.size());
+    }
+    t_Stack.push_back({ scope, Now() });
+}
+
+void Profiler::End() {
+    if (t_Stack.empty())
+        return;
+    OpenScope open = t_Stack.back();
+    t_Stack.pop_back();
+    uint64_t duration = Now() - open.start;
+    Event event{ open.scope->name, open.start, duration, ThreadIndex() };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    open.scope->frameTime += duration / 1000.f;
+    if (m_Events.size() < TRACE_CAPACITY) {
+        m_Events.push_back(event);
+    }
+    else {
+        m_Events[m_EventHead] = event;
+        m_EventHead = (m_EventHead + 1) % TRACE_CAPACITY;
+    }
+}
+
+void Profiler::AddSample(const char* name, float ms) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& scope = FindScope(name, 0);
+    scope.frameTime += ms;
+}
+
+void Profiler::EndFrame() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto& scope : m_Scopes) {
+        scope.history[m_Cursor] = scope.frameTime;
+        scope.frameTime = 0;
+    }
+    m_Cursor = (m_Cursor + 1) % HISTORY;
+}
+
+bool Profiler::WriteTrace(const char* path) const {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        writer.StartObject();
+        writer.Key("displayTimeUnit");
+        writer.String("ms");
+        writer.Key("traceEvents");
+        writer.StartArray();
+        for (size_t i = 0; i < m_Events.size(); i++) {
+            const auto& event = m_Events[(m_EventHead + i) % m_Events.size()];
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(event.name);
+            writer.Key("ph");
+            writer.String("X");
+            writer.Key("ts");
+            writer.Uint64(event.start);
+            writer.Key("dur");
+            writer.Uint64(event.duration);
+            writer.Key("pid");
+            writer.Uint(0);
+            writer.Key("tid");
+            writer.Uint(event.thread);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LogInfo("Could not open the file %s\n", path);
+        return false;
+    }
+    out.write(buffer.GetString(), buffer.GetSize());
+    LogInfo("Write Trace %s (%u events)\n", path, (unsigned)m_Events.size());
+    return out.good();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 分层 CPU 计时：按帧汇总各作用域的耗时并保留最近若干帧的历史，
+// 同时记录 trace 事件，可导出为 Chrome trace_event json（chrome://tracing 或 Perfetto 打开）
+// 作用域名须为字符串常量，可在任意线程使用
+class Profiler {
+public:
+	static constexpr int HISTORY = 120;
+
+	struct Scope {
+		const char* name;
+		int depth = 0;             // 首次出现时的嵌套深度，外部采样为 0
+		float frameTime = 0;       // 当前帧累计耗时（毫秒）
+		float history[HISTORY]{};  // 每帧耗时（毫秒），环形，写入位置为 Profiler::Cursor()
+	};
+
+	static Profiler& Get();
+
+	void Begin(const char* name);
+	void End();
+	// 外部测得的耗时，如 GL 计时查询，计入当前帧但不写入 trace
+	void AddSample(const char* name, float ms);
+	// 结束一帧，各作用域的累计耗时写入历史
+	void EndFrame();
+
+	// 按首次出现的顺序遍历全部作用域
+	template<class Func>
+	void Foreach(Func&& func) const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (const auto& scope : m_Scopes) {
+			func(scope);
+		}
+	}
+	// 下一帧写入历史的位置，即最旧的一帧
+	int Cursor() const {
+		return m_Cursor;
+	}
+
+	bool WriteTrace(const char* path) const;
+
+private:
+	struct Event {
+		const char* name;
+		uint64_t start;    // 微秒，自 Profiler 创建起
+		uint64_t duration; // 微秒
+		uint32_t thread;
+	};
+
+	Profiler();
+	uint64_t Now() const;
+	Scope& FindScope(const char* name, int depth);
+
+private:
+	// 保留的 trace 事件数，超出后覆盖最旧的事件
+	static constexpr size_t TRACE_CAPACITY = 1 << 16;
+
+	std::chrono::steady_clock::time_point m_Epoch;
+	mutable std::mutex m_Mutex;
+	std::deque<Scope> m_Scopes;
+	std::unordered_map<std::string_view, Scope*> m_ScopeIds;
+	int m_Cursor = 0;
+
+	std::vector<Event> m_Events;
+	size_t m_EventHead = 0;
+};
+
+class ProfileScope {
+public:
+	explicit ProfileScope(const char* name) {
+		Profiler::Get().Begin(name);
+	}
+	~ProfileScope() {
+		Profiler::Get().End();
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,57 @@
+#include "ProfilerPanel.h"
+#include <algorithm>
+#include <imgui.h>
+
+#include "Profiler.h"
+
+void ProfilerPanel::RenderImGui() {
+    auto& profiler = Profiler::Get();
+    if (ImGui::Button("导出 Trace (F9)"))
+        DumpTrace();
+    if (!m_Status.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(m_Status.c_str());
+    }
+
+    int flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV
+        | ImGuiTableFlags_SizingStretchProp;
+    if (!ImGui::BeginTable("##profiler", 4, flags))
+        return;
+    ImGui::TableSetupColumn("作用域");
+    ImGui::TableSetupColumn("平均(ms)");
+    ImGui::TableSetupColumn("最大(ms)");
+    ImGui::TableSetupColumn("历史");
+    ImGui::TableHeadersRow();
+
+    int cursor = profiler.Cursor();
+    profiler.Foreach([cursor](const Profiler::Scope& scope) {
+        float sum = 0, peak = 0;
+        for (float value : scope.history) {
+            sum += value;
+            peak = std::max(peak, value);
+        }
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Indent(scope.depth * 8.f + 1);
+        ImGui::TextUnformatted(scope.name);
+        ImGui::Unindent(scope.depth * 8.f + 1);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", sum / Profiler::HISTORY);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", peak);
+        ImGui::TableNextColumn();
+        ImGui::PushID(scope.name);
+        ImGui::PlotHistogram("##history", scope.history, Profiler::HISTORY, cursor,
+            nullptr, 0.f, std::max(peak, 1.f), ImVec2(-1, 24));
+        ImGui::PopID();
+    });
+    ImGui::EndTable();
+}
+
+void ProfilerPanel::DumpTrace() {
+    if (Profiler::Get().WriteTrace(TRACE_FILE))
+        m_Status = std::string("已写入 ") + TRACE_FILE;
+    else
+        m_Status = std::string("无法写入 ") + TRACE_FILE;
+}
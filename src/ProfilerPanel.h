@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+// 性能面板：各作用域最近若干帧的耗时与历史直方图，可导出 Chrome trace
+class ProfilerPanel {
+public:
+    static constexpr const char* TRACE_FILE = "trace.json";
+
+    void RenderImGui();
+    void DumpTrace();
+
+private:
+    std::string m_Status;
+};
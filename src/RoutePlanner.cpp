@@ -0,0 +1,191 @@
+#include "RoutePlanner.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+// 单次规划的时间预算，超出后返回当前最好的路线
+static constexpr int PLAN_BUDGET_US = 5000;
+// 小于此值的改进视为没有改进，避免浮点误差导致来回交换
+static constexpr float IMPROVE_EPSILON = 1e-3f;
+// Or-opt 移动的最长连续段
+static constexpr uint32_t OR_OPT_SEGMENT = 3;
+
+// 参与规划的地点种类：落地点在 Minor Base 中，终点为缩圈
+static constexpr LocationType ROUTE_TYPES[] = {
+    eMinorBase, eMajorBase, eEvergaol, eFieldBoss, eCircle,
+};
+
+void RoutePlanner::Clear() {
+    m_Thumbnail = nullptr;
+    std::fill(std::begin(m_First), std::end(m_First), UINT32_MAX);
+    m_Points.clear();
+    m_Valid.clear();
+    m_Distances.clear();
+}
+
+void RoutePlanner::Reset(const MapThumbnail& thumbnail) {
+    Clear();
+    m_Thumbnail = &thumbnail;
+    for (auto loc : ROUTE_TYPES) {
+        m_First[loc] = (uint32_t)m_Points.size();
+        for (uint16_t id = 0; id < thumbnail.LocationCount(loc); id++) {
+            auto pos = thumbnail.Query(loc, id);
+            m_Points.push_back(pos ? glm::vec2(*pos) : glm::vec2(0));
+            m_Valid.push_back(pos != nullptr);
+        }
+    }
+
+    size_t n = m_Points.size();
+    m_Distances.assign(n * n, 0.f);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            float d = glm::distance(m_Points[i], m_Points[j]);
+            m_Distances[i * n + j] = d;
+            m_Distances[j * n + i] = d;
+        }
+    }
+}
+
+uint32_t RoutePlanner::Index(LocationType loc, uint16_t id) const {
+    if (!m_Thumbnail || m_First[loc] == UINT32_MAX || id >= m_Thumbnail->LocationCount(loc))
+        return UINT32_MAX;
+    uint32_t i = m_First[loc] + id;
+    return m_Valid[i] ? i : UINT32_MAX;
+}
+
+float RoutePlanner::Plan(const EmdbSeed& seed, uint32_t types, std::vector<glm::vec2>& route) const {
+    route.clear();
+    uint32_t start = Index(eMinorBase, seed.spawn_point);
+    uint32_t end = Index(eCircle, seed.night_1_circle);
+    if (start == UINT32_MAX || end == UINT32_MAX)
+        return 0.f;
+
+    std::vector<uint32_t> stops;
+    for (auto loc : ROUTE_TYPES) {
+        if (0 == (types & STOP_TYPES & (1u << loc)))
+            continue;
+        for (uint16_t id = 0; id < m_Thumbnail->LocationCount(loc); id++) {
+            uint32_t i = Index(loc, id);
+            if (i != UINT32_MAX && i != start
+                && m_Thumbnail->ValueOf(seed, loc, id) != EMDB_EMPTY_STRING)
+                stops.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> order;
+    float length = Plan(start, end, stops, order);
+    for (uint32_t i : order) {
+        route.push_back(m_Points[i]);
+    }
+    return length;
+}
+
+// 反转 tour[i..j] 使 (tour[i-1], tour[i]) 与 (tour[j], tour[j+1]) 两条边变短时执行，起终点不动
+static bool TwoOpt(std::vector<uint32_t>& tour, const float* d, uint32_t m) {
+    bool improved = false;
+    for (uint32_t i = 1; i + 1 < m; i++) {
+        for (uint32_t j = i + 1; j + 1 < m; j++) {
+            uint32_t a = tour[i - 1], b = tour[i], c = tour[j], e = tour[j + 1];
+            float delta = d[a * m + c] + d[b * m + e] - d[a * m + b] - d[c * m + e];
+            if (delta < -IMPROVE_EPSILON) {
+                std::reverse(tour.begin() + i, tour.begin() + j + 1);
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+// 把 1 到 OR_OPT_SEGMENT 个连续的途经点整体（可反向）移到另一条边上
+static bool OrOpt(std::vector<uint32_t>& tour, const float* d, uint32_t m) {
+    bool improved = false;
+    std::vector<uint32_t> segment;
+    for (uint32_t len = 1; len <= OR_OPT_SEGMENT; len++) {
+        for (uint32_t i = 1; i + len < m; i++) {
+            uint32_t prev = tour[i - 1], first = tour[i];
+            uint32_t last = tour[i + len - 1], next = tour[i + len];
+            float removed = d[prev * m + first] + d[last * m + next] - d[prev * m + next];
+
+            uint32_t bestEdge = UINT32_MAX;
+            bool bestReverse = false;
+            float bestDelta = -IMPROVE_EPSILON;
+            for (uint32_t p = 0; p + 1 < m; p++) {
+                if (p + 1 >= i && p < i + len)
+                    continue;
+                uint32_t u = tour[p], v = tour[p + 1];
+                float forward = d[u * m + first] + d[last * m + v];
+                float backward = d[u * m + last] + d[first * m + v];
+                float delta = std::min(forward, backward) - d[u * m + v] - removed;
+                if (delta < bestDelta) {
+                    bestDelta = delta;
+                    bestEdge = p;
+                    bestReverse = backward < forward;
+                }
+            }
+            if (bestEdge == UINT32_MAX)
+                continue;
+
+            segment.assign(tour.begin() + i, tour.begin() + i + len);
+            if (bestReverse)
+                std::reverse(segment.begin(), segment.end());
+            tour.erase(tour.begin() + i, tour.begin() + i + len);
+            uint32_t at = bestEdge < i ? bestEdge + 1 : bestEdge + 1 - len;
+            tour.insert(tour.begin() + at, segment.begin(), segment.end());
+            improved = true;
+        }
+    }
+    return improved;
+}
+
+float RoutePlanner::Plan(uint32_t start, uint32_t end, const std::vector<uint32_t>& stops,
+    std::vector<uint32_t>& route) const {
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + std::chrono::microseconds(PLAN_BUDGET_US);
+
+    // 局部编号：0 为起点，1..m-2 为途经点，m-1 为终点
+    std::vector<uint32_t> points;
+    points.reserve(stops.size() + 2);
+    points.push_back(start);
+    points.insert(points.end(), stops.begin(), stops.end());
+    points.push_back(end);
+    uint32_t m = (uint32_t)points.size();
+    std::vector<float> local(size_t(m) * m);
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = 0; j < m; j++) {
+            local[size_t(i) * m + j] = Distance(points[i], points[j]);
+        }
+    }
+    const float* d = local.data();
+
+    // 最近邻构造初始路线
+    std::vector<uint32_t> tour;
+    tour.reserve(m);
+    tour.push_back(0);
+    std::vector<bool> visited(m, false);
+    for (uint32_t k = 1; k + 1 < m; k++) {
+        uint32_t from = tour.back();
+        uint32_t best = UINT32_MAX;
+        for (uint32_t j = 1; j + 1 < m; j++) {
+            if (!visited[j] && (best == UINT32_MAX || d[from * m + j] < d[from * m + best]))
+                best = j;
+        }
+        visited[best] = true;
+        tour.push_back(best);
+    }
+    tour.push_back(m - 1);
+
+    bool improved = true;
+    while (improved && Clock::now() < deadline) {
+        improved = TwoOpt(tour, d, m);
+        improved = OrOpt(tour, d, m) || improved;
+    }
+
+    float length = 0.f;
+    route.clear();
+    for (uint32_t k = 0; k < m; k++) {
+        route.push_back(points[tour[k]]);
+        if (k > 0)
+            length += d[tour[k - 1] * m + tour[k]];
+    }
+    return length;
+}
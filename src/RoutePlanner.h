@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AssetUtils.h"
+
+// 从落地点出发、经过选定种类的全部地点、到第一天缩圈的较短路线（地图像素的直线距离）。
+// 换地形时预先计算落地点、缩圈与可选地点两两之间的距离；
+// 规划时取出涉及的子矩阵，最近邻构造初始路线后交替 2-opt 与 Or-opt 直到没有改进或超出时间预算
+class RoutePlanner {
+public:
+	// 可选地点的种类，types 为 1 << LocationType 的组合
+	static constexpr uint32_t STOP_TYPES = (1u << eMajorBase) | (1u << eEvergaol) | (1u << eFieldBoss);
+
+	void Reset(const MapThumbnail& thumbnail);
+	void Clear();
+
+	uint32_t PointCount() const {
+		return (uint32_t)m_Points.size();
+	}
+	const glm::vec2& Point(uint32_t i) const {
+		return m_Points[i];
+	}
+	float Distance(uint32_t a, uint32_t b) const {
+		return m_Distances[size_t(a) * m_Points.size() + b];
+	}
+	// 地点在矩阵中的序号，未登记或没有坐标时返回 UINT32_MAX
+	uint32_t Index(LocationType loc, uint16_t id) const;
+
+	// seed 中 types 种类的地点作为途经点，route 为依次经过的地图坐标，返回路线长度。
+	// 落地点或缩圈没有坐标时 route 为空
+	float Plan(const EmdbSeed& seed, uint32_t types, std::vector<glm::vec2>& route) const;
+	// 从 start 经过全部 stops 到 end，route 为依次经过的点序号（含起终点）
+	float Plan(uint32_t start, uint32_t end, const std::vector<uint32_t>& stops,
+		std::vector<uint32_t>& route) const;
+
+private:
+	const MapThumbnail* m_Thumbnail = nullptr;
+	// 各种类地点在 m_Points 中的起始序号，不参与规划的种类为 UINT32_MAX
+	uint32_t m_First[eLocationTypeCount] = {};
+	std::vector<glm::vec2> m_Points;
+	std::vector<bool> m_Valid;
+	std::vector<float> m_Distances;
+};
@@ -0,0 +1,553 @@
+#include "SeedDatabase.h"
+#include "AssetUtils.h"
+#include "SeedTree.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include <rapidjson/reader.h>
+
+#include "LogUtils.h"
+
+static std::string LOC_PATH(const char* name) {
+    return std::string("loc ") + name + ".json";
+}
+
+static std::string MAP_PATH(const char* name) {
+    return std::string("map ") + name + ".json";
+}
+
+// 按 LocationType 顺序对应的 loc *.json
+static const char* LOCATION_FILES[eLocationTypeCount] = {
+    "Minor Base",
+    "Major Base",
+    "Evergaol",
+    "Field Boss",
+    "Circle",
+    "Rotted Woods",
+    "Rot Blessing",
+    "Frenzy Tower",
+    "Demon Merchant",
+};
+
+struct LocationFile {
+    std::vector<std::pair<std::string, glm::ivec2>> entries;
+};
+
+// 进程内共享的地点缓存，每个 loc *.json 最多读取一次
+static const LocationFile* LoadLocationFile(const char* source) {
+    static std::mutex mutex;
+    static std::map<std::string, LocationFile> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto itr = cache.find(source);
+    if (itr != cache.end())
+        return &itr->second;
+
+    JsonAsset locJson;
+    if (!locJson.Load(LOC_PATH(source).c_str()))
+        return nullptr;
+
+    auto& file = cache[source];
+    auto& doc = locJson.GetDoc();
+    for (auto member = doc.MemberBegin(); member != doc.MemberEnd(); ++member) {
+        if (!member->value.IsString())
+            continue;
+        glm::ivec2 pos{};
+        toivec2(pos, member->value.GetString());
+        file.entries.emplace_back(member->name.GetString(), pos);
+    }
+    return &file;
+}
+
+SeedCompiler::SeedCompiler() {
+    RehashStrings();
+    Intern("");
+    for (int loc = 0; loc < eLocationTypeCount; loc++) {
+        auto file = LoadLocationFile(LOCATION_FILES[loc]);
+        if (!file)
+            return;
+        if (file->entries.size() > EMDB_MAX_LOCATIONS) {
+            LogInfo("Too many locations in %s\n", LOCATION_FILES[loc]);
+            return;
+        }
+
+        auto& type = m_Types[loc];
+        type.first = (uint32_t)m_Locations.size();
+        type.count = (uint32_t)file->entries.size();
+        for (auto& entry : file->entries) {
+            m_LocationIds[loc].emplace(entry.first,
+                (uint16_t)(m_Locations.size() - type.first));
+            m_Locations.push_back({ Intern(entry.first), entry.second });
+        }
+    }
+    m_SeedStride = (uint32_t)(sizeof(EmdbSeed)
+        + sizeof(uint16_t) * m_Locations.size() + 3) & ~3u;
+    m_Valid = true;
+}
+
+uint16_t SeedCompiler::Intern(std::string_view str) {
+    size_t hash = std::hash<std::string_view>()(str);
+    size_t mask = m_StringSlots.size() - 1;
+    size_t pos = hash & mask;
+    for (; m_StringSlots[pos]; pos = (pos + 1) & mask) {
+        uint16_t id = m_StringSlots[pos] - 1;
+        if (m_StringHashes[id] == hash && m_Strings[id] == str)
+            return id;
+    }
+    // 字符串 id 为 uint16，超出后会回绕并与 EMDB_EMPTY_STRING 等已有 id 冲突
+    if (m_Strings.size() >= UINT16_MAX) {
+        if (m_Valid)
+            LogInfo("Too many strings for the seed database\n");
+        m_Valid = false;
+        return EMDB_EMPTY_STRING;
+    }
+    uint16_t id = (uint16_t)m_Strings.size();
+    m_Strings.emplace_back(str);
+    m_StringHashes.push_back(hash);
+    m_StringSlots[pos] = id + 1;
+    if (m_Strings.size() * 2 > m_StringSlots.size())
+        RehashStrings();
+    return id;
+}
+
+void SeedCompiler::RehashStrings() {
+    m_StringSlots.assign(std::max<size_t>(m_StringSlots.size() * 2, 256), 0);
+    size_t mask = m_StringSlots.size() - 1;
+    for (size_t id = 0; id < m_Strings.size(); id++) {
+        size_t pos = m_StringHashes[id] & mask;
+        while (m_StringSlots[pos])
+            pos = (pos + 1) & mask;
+        m_StringSlots[pos] = (uint16_t)(id + 1);
+    }
+}
+
+uint16_t SeedCompiler::FindLocation(LocationType loc, std::string_view name) const {
+    auto itr = m_LocationIds[loc].find(name);
+    if (itr == m_LocationIds[loc].end())
+        return EMDB_NO_LOCATION;
+    return itr->second;
+}
+
+struct SeedKey {
+    const char* key;
+    uint16_t EmdbSeed::* member; // 字符串字段或地点字段
+    LocationType type;           // 地点类型，eLocationTypeCount 表示普通字符串
+    const char* nested;          // 对象内的字符串字段，如 Castle.Castle
+};
+
+static const SeedKey SEED_KEYS[] = {
+    { "Nightlord", &EmdbSeed::nightlord, eLocationTypeCount, nullptr },
+    { "Shifting Earth", &EmdbSeed::shifting_earth, eLocationTypeCount, nullptr },
+    { "Spawn Point", &EmdbSeed::spawn_point, eMinorBase, nullptr },
+    { "Special Event", &EmdbSeed::special_event, eLocationTypeCount, nullptr },
+    { "Night 1 Boss", &EmdbSeed::night_1_boss, eLocationTypeCount, nullptr },
+    { "Night 2 Boss", &EmdbSeed::night_2_boss, eLocationTypeCount, nullptr },
+    { "Extra Night Boss", &EmdbSeed::extra_boss, eLocationTypeCount, nullptr },
+    { "Night 1 Circle", &EmdbSeed::night_1_circle, eCircle, nullptr },
+    { "Night 2 Circle", &EmdbSeed::night_2_circle, eCircle, nullptr },
+    { "Castle", &EmdbSeed::castle_type, eLocationTypeCount, "Castle" },
+    { "Major Base", nullptr, eMajorBase, nullptr },
+    { "Minor Base", nullptr, eMinorBase, nullptr },
+    { "Evergaol", nullptr, eEvergaol, nullptr },
+    { "Arena Boss", &EmdbSeed::castle_basement, eLocationTypeCount, "Castle Basement" },
+    { "Field Boss", &EmdbSeed::castle_rooftop, eFieldBoss, "Castle Rooftop" },
+    { "Rotted Woods", nullptr, eRottedWoods, nullptr },
+    { "Rot Blessing", &EmdbSeed::rot_blessing, eRotBlessing, nullptr },
+    { "Frenzy Tower", &EmdbSeed::frenzy_tower, eFrenzyTower, nullptr },
+    { "Scale-Bearing Merchant", &EmdbSeed::demon_merchant, eDemonMerchant, nullptr },
+};
+
+static const SeedKey* FindSeedKey(std::string_view key) {
+    static const std::unordered_map<std::string_view, const SeedKey*> keys = [] {
+        std::unordered_map<std::string_view, const SeedKey*> result;
+        for (const auto& seedKey : SEED_KEYS) {
+            result.emplace(seedKey.key, &seedKey);
+        }
+        return result;
+    }();
+    auto itr = keys.find(key);
+    return itr == keys.end() ? nullptr : itr->second;
+}
+
+// map *.json 的 SAX 处理器：顶层数组的每个对象是一个种子，字段值为字符串或
+// { 名字: 字符串 } 对象，其余取值与更深的嵌套一律忽略
+struct SeedCompiler::SeedReader
+    : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SeedReader> {
+    SeedCompiler& compiler;
+    EmdbTerrain& terrain;
+    bool root = false;    // 顶层为数组
+    int depth = 0;        // 当前所在的容器层数，种子对象为 2，字段对象为 3
+    EmdbSeed seed{};
+    size_t record = 0;    // 当前种子记录在种子表中的偏移
+    bool index = false;   // 当前字段为 index
+    const SeedKey* key = nullptr;         // 当前字段，未知字段为 nullptr
+    bool nested = false;                  // 字段对象内当前名字为 key->nested
+    uint16_t location = EMDB_NO_LOCATION; // 字段对象内当前名字对应的地点
+
+    SeedReader(SeedCompiler& compiler, EmdbTerrain& terrain)
+        : compiler(compiler), terrain(terrain) {
+    }
+
+    // 解析地点的同时记录该地形出现过的地点
+    uint16_t Location(LocationType type, std::string_view name) {
+        uint16_t id = compiler.FindLocation(type, name);
+        if (id != EMDB_NO_LOCATION)
+            terrain.present[type] |= 1u << id;
+        return id;
+    }
+    uint16_t* Values() {
+        return reinterpret_cast<uint16_t*>(compiler.m_SeedTable.data() + record + sizeof(EmdbSeed));
+    }
+
+    void BeginSeed() {
+        seed = {};
+        for (const auto& seedKey : SEED_KEYS) {
+            if (seedKey.member && seedKey.type != eLocationTypeCount && !seedKey.nested)
+                seed.*seedKey.member = EMDB_NO_LOCATION;
+        }
+        record = compiler.m_SeedTable.size();
+        compiler.m_SeedTable.resize(record + compiler.m_SeedStride, 0);
+    }
+    void EndSeed() {
+        memcpy(compiler.m_SeedTable.data() + record, &seed, sizeof(seed));
+        terrain.seedCount++;
+    }
+
+    bool StartArray() {
+        if (depth == 0)
+            root = true;
+        else if (depth == 2)
+            key = nullptr, index = false;
+        depth++;
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        depth--;
+        return true;
+    }
+    bool StartObject() {
+        depth++;
+        if (depth == 2) {
+            BeginSeed();
+        }
+        else if (depth == 3 && key) {
+            // 对象中缺少 nested 字段时取空字符串
+            if (key->nested)
+                seed.*key->member = EMDB_EMPTY_STRING;
+            nested = false;
+            location = EMDB_NO_LOCATION;
+        }
+        return root;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        if (depth == 2)
+            EndSeed();
+        else if (depth == 3)
+            key = nullptr;
+        depth--;
+        return true;
+    }
+
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        std::string_view name(str, length);
+        if (depth == 2) {
+            index = name == "index";
+            key = FindSeedKey(name);
+        }
+        else if (depth == 3 && key) {
+            nested = key->nested && name == key->nested;
+            location = key->type == eLocationTypeCount
+                ? EMDB_NO_LOCATION : Location(key->type, name);
+        }
+        return true;
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        std::string_view value(str, length);
+        if (depth == 2 && key && key->member && !key->nested) {
+            if (key->type == eLocationTypeCount)
+                seed.*key->member = compiler.Intern(value);
+            else
+                seed.*key->member = Location(key->type, value);
+        }
+        else if (depth == 3 && key) {
+            if (nested)
+                seed.*key->member = compiler.Intern(value);
+            if (location != EMDB_NO_LOCATION)
+                Values()[compiler.m_Types[key->type].first + location] = compiler.Intern(value);
+        }
+        return true;
+    }
+    bool Int(int value) {
+        if (depth == 2 && index)
+            seed.index = (uint16_t)value;
+        return true;
+    }
+    bool Uint(unsigned value) {
+        return value <= INT_MAX ? Int((int)value) : true;
+    }
+};
+
+bool SeedCompiler::LoadTerrain(std::string_view name) {
+    if (!m_Valid)
+        return false;
+
+    EmdbTerrain terrain{};
+    terrain.name = Intern(name);
+    terrain.seedOffset = (uint32_t)m_SeedTable.size();
+
+    SeedReader handler(*this, terrain);
+    bool loaded = ReadData(MAP_PATH(std::string(name).c_str()).c_str(), m_MapText);
+    if (loaded) {
+        rapidjson::InsituStringStream stream(m_MapText.data());
+        rapidjson::Reader reader;
+        loaded = !reader.Parse<rapidjson::kParseInsituFlag>(stream, handler).IsError() && handler.root;
+    }
+    loaded = loaded && m_Valid;
+    if (!loaded) {
+        m_SeedTable.resize(terrain.seedOffset);
+        LogInfo("Failed to load map %s\n", std::string(name).c_str());
+        return false;
+    }
+    m_Terrains.push_back(terrain);
+    return true;
+}
+
+static void Align(std::vector<char>& image) {
+    image.resize((image.size() + 3) & ~size_t(3), 0);
+}
+
+template<class T>
+static uint32_t Append(std::vector<char>& image, const T* data, size_t count) {
+    Align(image);
+    uint32_t offset = (uint32_t)image.size();
+    const char* bytes = reinterpret_cast<const char*>(data);
+    image.insert(image.end(), bytes, bytes + sizeof(T) * count);
+    return offset;
+}
+
+void SeedCompiler::Finish(std::vector<char>& image) const {
+    EmdbHeader header{};
+    header.magic = EMDB_MAGIC;
+    header.version = EMDB_VERSION;
+    header.locationCount = (uint32_t)m_Locations.size();
+    std::copy(std::begin(m_Types), std::end(m_Types), header.types);
+    header.seedStride = m_SeedStride;
+
+    std::vector<uint32_t> stringOffsets;
+    std::vector<char> stringData;
+    for (auto& str : m_Strings) {
+        stringOffsets.push_back((uint32_t)stringData.size());
+        stringData.insert(stringData.end(), str.begin(), str.end());
+        stringData.push_back('\0');
+    }
+
+    image.assign(sizeof(EmdbHeader), 0);
+    header.stringCount = (uint32_t)m_Strings.size();
+    header.stringOffset = Append(image, stringOffsets.data(), stringOffsets.size());
+    header.stringDataOffset = Append(image, stringData.data(), stringData.size());
+    header.locationOffset = Append(image, m_Locations.data(), m_Locations.size());
+    Align(image);
+    header.terrainCount = (uint32_t)m_Terrains.size();
+    header.terrainOffset = (uint32_t)image.size();
+    header.seedOffset = (uint32_t)(image.size() + sizeof(EmdbTerrain) * m_Terrains.size());
+
+    auto terrains = m_Terrains;
+    for (auto& terrain : terrains) {
+        terrain.seedOffset += header.seedOffset;
+    }
+    Append(image, terrains.data(), terrains.size());
+    Append(image, m_SeedTable.data(), m_SeedTable.size());
+    header.size = (uint32_t)image.size();
+    memcpy(image.data(), &header, sizeof(header));
+}
+
+bool SeedDatabase::Compile(const std::vector<std::string_view>& terrains,
+    std::vector<char>& image, float distanceWeight) {
+    SeedCompiler compiler;
+    if (!compiler.IsValid())
+        return false;
+    for (auto name : terrains) {
+        if (!compiler.LoadTerrain(name))
+            return false;
+    }
+    compiler.Finish(image);
+
+    // 决策树基于已编译的种子表构建，再追加到镜像末尾
+    SeedTreeBuilder trees(distanceWeight);
+    {
+        SeedDatabase database;
+        if (!database.Attach(image.data(), image.size()))
+            return false;
+        for (uint32_t i = 0; i < database.TerrainCount(); i++) {
+            MapThumbnail thumbnail;
+            thumbnail.LoadMap(database, database.String(database.Terrain(i).name));
+            SeedIndex index;
+            index.Build(thumbnail);
+            trees.Build(thumbnail, index, i);
+        }
+    }
+    trees.Finish(image);
+    return true;
+}
+
+SeedDatabase::~SeedDatabase() {
+    Cleanup();
+}
+
+void SeedDatabase::Cleanup() {
+    m_File.Close();
+    std::vector<char>().swap(m_Image);
+    m_Data = nullptr;
+    m_Header = nullptr;
+}
+
+bool SeedDatabase::Open(const char* fname) {
+    Cleanup();
+    std::string path = DATA_DIR(fname);
+    if (!m_File.Open(path.c_str())) {
+        LogInfo("Could not open the file %s\n", path.c_str());
+        return false;
+    }
+
+    if (!Attach(m_File.Data(), m_File.Size())) {
+        LogInfo("Invalid seed database %s\n", path.c_str());
+        Cleanup();
+        return false;
+    }
+    LogInfo("Load Database %s (%u bytes)\n", path.c_str(), (unsigned)m_File.Size());
+    return true;
+}
+
+bool SeedDatabase::Build(const std::vector<std::string_view>& terrains) {
+    Cleanup();
+    std::vector<char> image;
+    if (!Compile(terrains, image))
+        return false;
+    m_Image.swap(image);
+    return Attach(m_Image.data(), m_Image.size());
+}
+
+bool SeedDatabase::Attach(const char* data, size_t size) {
+    if (size < sizeof(EmdbHeader))
+        return false;
+    auto header = reinterpret_cast<const EmdbHeader*>(data);
+    if (header->magic != EMDB_MAGIC || header->version != EMDB_VERSION
+        || header->size != size)
+        return false;
+
+    auto inside = [size](uint64_t offset, uint64_t bytes) {
+        return offset + bytes <= size;
+    };
+    if (!inside(header->stringOffset, sizeof(uint32_t) * (uint64_t)header->stringCount)
+        || !inside(header->locationOffset, sizeof(EmdbLocation) * (uint64_t)header->locationCount)
+        || !inside(header->terrainOffset, sizeof(EmdbTerrain) * (uint64_t)header->terrainCount)
+        || !inside(header->treeOffset, sizeof(EmdbTree) * (uint64_t)header->treeCount)
+        || !inside(header->treeNodeOffset, sizeof(EmdbTreeNode) * (uint64_t)header->treeNodeCount)
+        || !inside(header->treeBranchOffset, sizeof(EmdbTreeBranch) * (uint64_t)header->treeBranchCount)
+        || header->seedStride < sizeof(EmdbSeed) + sizeof(uint16_t) * (uint64_t)header->locationCount)
+        return false;
+
+    for (const auto& type : header->types) {
+        if ((uint64_t)type.first + type.count > header->locationCount
+            || type.count > EMDB_MAX_LOCATIONS)
+            return false;
+    }
+
+    // 字符串数据位于偏移表与地点表之间，每个字符串都要在此范围内以 0 结尾
+    uint64_t stringTable = header->stringOffset + sizeof(uint32_t) * (uint64_t)header->stringCount;
+    if (header->stringCount == 0 || header->stringDataOffset < stringTable
+        || header->stringDataOffset > header->locationOffset)
+        return false;
+    const char* stringData = data + header->stringDataOffset;
+    uint32_t stringSize = header->locationOffset - header->stringDataOffset;
+    uint32_t terminated = stringSize; // 最后一个 0 之后的位置
+    while (terminated > 0 && stringData[terminated - 1] != '\0') {
+        terminated--;
+    }
+    auto stringOffsets = reinterpret_cast<const uint32_t*>(data + header->stringOffset);
+    for (uint32_t i = 0; i < header->stringCount; i++) {
+        if (stringOffsets[i] >= terminated)
+            return false;
+    }
+
+    auto terrains = reinterpret_cast<const EmdbTerrain*>(data + header->terrainOffset);
+    for (uint32_t i = 0; i < header->terrainCount; i++) {
+        if (!inside(terrains[i].seedOffset,
+            (uint64_t)header->seedStride * terrains[i].seedCount))
+            return false;
+    }
+
+    auto trees = reinterpret_cast<const EmdbTree*>(data + header->treeOffset);
+    for (uint32_t i = 0; i < header->treeCount; i++) {
+        if (trees[i].terrain >= header->terrainCount || trees[i].root >= header->treeNodeCount)
+            return false;
+    }
+    auto nodes = reinterpret_cast<const EmdbTreeNode*>(data + header->treeNodeOffset);
+    for (uint32_t i = 0; i < header->treeNodeCount; i++) {
+        // 内部节点检查的地点要有逐地点字段，叶节点只能是 eLocationTypeCount
+        uint16_t type = nodes[i].type;
+        if (type > eLocationTypeCount
+            || (type < eLocationTypeCount && GetLocationField((LocationType)type) == eSeedFieldCount))
+            return false;
+        if ((uint64_t)nodes[i].firstBranch + nodes[i].branchCount > header->treeBranchCount)
+            return false;
+    }
+    auto branches = reinterpret_cast<const EmdbTreeBranch*>(data + header->treeBranchOffset);
+    for (uint32_t i = 0; i < header->treeBranchCount; i++) {
+        if (branches[i].node >= header->treeNodeCount)
+            return false;
+    }
+
+    // 节点记录的种子序号在所属地形内，从每棵树的根遍历，同一棵树内每个节点只访问一次
+    std::vector<uint32_t> visited(header->treeNodeCount, UINT32_MAX);
+    std::vector<uint32_t> stack;
+    for (uint32_t i = 0; i < header->treeCount; i++) {
+        uint32_t seedCount = terrains[trees[i].terrain].seedCount;
+        stack.assign(1, trees[i].root);
+        while (!stack.empty()) {
+            uint32_t id = stack.back();
+            stack.pop_back();
+            if (visited[id] == i)
+                continue;
+            visited[id] = i;
+            const auto& node = nodes[id];
+            if (node.seed >= seedCount)
+                return false;
+            for (uint32_t b = 0; b < node.branchCount; b++) {
+                stack.push_back(branches[node.firstBranch + b].node);
+            }
+        }
+    }
+
+    m_Data = data;
+    m_Header = header;
+    return true;
+}
+
+const char* SeedDatabase::String(uint32_t id) const {
+    if (id >= m_Header->stringCount)
+        return "";
+    return m_Data + m_Header->stringDataOffset + At<uint32_t>(m_Header->stringOffset)[id];
+}
+
+const EmdbTerrain* SeedDatabase::FindTerrain(std::string_view name) const {
+    for (uint32_t i = 0; i < TerrainCount(); i++) {
+        if (name == String(Terrain(i).name))
+            return &Terrain(i);
+    }
+    return nullptr;
+}
+
+const EmdbTree* SeedDatabase::FindTree(const EmdbTerrain& terrain, uint16_t spawn) const {
+    auto trees = At<EmdbTree>(m_Header->treeOffset);
+    for (uint32_t i = 0; i < m_Header->treeCount; i++) {
+        if (&Terrain(trees[i].terrain) == &terrain && trees[i].spawn == spawn)
+            return &trees[i];
+    }
+    return nullptr;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+enum LocationType {
+	eMinorBase,
+	eMajorBase,
+	eEvergaol,
+	eFieldBoss,
+	eCircle,
+	eRottedWoods,
+	eRotBlessing,
+	eFrenzyTower,
+	eDemonMerchant,
+	eLocationTypeCount,
+};
+
+// seeds.emdb 二进制布局（小端）
+// [EmdbHeader][字符串偏移表][字符串数据][EmdbLocation...][EmdbTerrain...][种子表]
+// [EmdbTree...][EmdbTreeNode...][EmdbTreeBranch...]
+// 种子表每条记录定长 seedStride：EmdbSeed 后紧跟每个地点一个 uint16 字符串 id
+constexpr uint32_t EMDB_MAGIC = 0x42444D45; // "EMDB"
+constexpr uint32_t EMDB_VERSION = 2;
+constexpr uint16_t EMDB_NO_LOCATION = 0xFFFF;
+constexpr uint16_t EMDB_EMPTY_STRING = 0;
+// 每种地点的上限，地形中出现过的地点按 uint32 位掩码记录
+constexpr uint32_t EMDB_MAX_LOCATIONS = 32;
+
+struct EmdbLocationType {
+	uint32_t first;
+	uint32_t count;
+};
+
+struct EmdbHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t stringCount;
+	uint32_t stringOffset;
+	uint32_t stringDataOffset;
+	uint32_t locationCount;
+	uint32_t locationOffset;
+	EmdbLocationType types[eLocationTypeCount];
+	uint32_t terrainCount;
+	uint32_t terrainOffset;
+	uint32_t seedStride;
+	uint32_t seedOffset;
+	uint32_t treeCount;
+	uint32_t treeOffset;
+	uint32_t treeNodeCount;
+	uint32_t treeNodeOffset;
+	uint32_t treeBranchCount;
+	uint32_t treeBranchOffset;
+};
+
+struct EmdbLocation {
+	uint32_t name;
+	glm::ivec2 pos;
+};
+
+struct EmdbTerrain {
+	uint32_t name;
+	uint32_t seedCount;
+	uint32_t seedOffset;
+	// 该地形种子中出现过的地点（按 LocationType 的位掩码）
+	uint32_t present[eLocationTypeCount];
+};
+
+// 字符串字段存字符串 id，地点字段存对应 LocationType 内的地点 id
+struct EmdbSeed {
+	uint16_t index;
+	uint16_t nightlord;
+	uint16_t shifting_earth;
+	uint16_t special_event;
+	uint16_t night_1_boss;
+	uint16_t night_2_boss;
+	uint16_t extra_boss;
+	uint16_t castle_type;
+	uint16_t castle_basement;
+	uint16_t castle_rooftop;
+	uint16_t spawn_point;
+	uint16_t night_1_circle;
+	uint16_t night_2_circle;
+	uint16_t rot_blessing;
+	uint16_t frenzy_tower;
+	uint16_t demon_merchant;
+
+	// 按全局地点序号索引的字符串 id，如 Major Base 各据点的营地类型
+	const uint16_t* Values() const {
+		return reinterpret_cast<const uint16_t*>(this + 1);
+	}
+};
+
+static_assert(sizeof(EmdbSeed) % 4 == 0, "EmdbSeed must keep 4-byte alignment");
+
+// 每个 (地形, 落地点) 的识别决策树
+struct EmdbTree {
+	uint32_t terrain; // 地形序号
+	uint16_t spawn;   // Minor Base 地点 id
+	uint16_t reserved;
+	uint32_t root;    // 根节点序号
+};
+
+// 内部节点检查 (type, slot) 处的取值，叶节点 type 为 eLocationTypeCount
+struct EmdbTreeNode {
+	uint16_t type;
+	uint16_t slot;
+	uint16_t seed;      // 叶节点：剩余种子中第一个在地形内的序号
+	uint16_t seedCount; // 到达该节点时剩余的种子数
+	uint32_t branchCount;
+	uint32_t firstBranch;
+	float expected;     // 从该节点起确定种子的期望代价
+};
+
+struct EmdbTreeBranch {
+	uint16_t value; // 观察到的字符串 id
+	uint16_t reserved;
+	uint32_t node;
+};
+
+class SeedDatabase {
+public:
+	SeedDatabase() = default;
+	SeedDatabase(const SeedDatabase&) = delete;
+	SeedDatabase& operator=(const SeedDatabase&) = delete;
+	~SeedDatabase();
+
+	void Cleanup();
+	// 映射编译好的 .emdb 文件，校验失败返回 false
+	bool Open(const char* fname);
+	// 从 json 源数据在内存中编译，.emdb 缺失时使用
+	bool Build(const std::vector<std::string_view>& terrains);
+	bool IsValid() const {
+		return m_Header != nullptr;
+	}
+
+	const char* String(uint32_t id) const;
+	uint32_t StringCount() const {
+		return m_Header->stringCount;
+	}
+	uint32_t TerrainCount() const {
+		return m_Header->terrainCount;
+	}
+	const EmdbTerrain& Terrain(uint32_t i) const {
+		return At<EmdbTerrain>(m_Header->terrainOffset)[i];
+	}
+	const EmdbTerrain* FindTerrain(std::string_view name) const;
+
+	const EmdbLocationType& Type(LocationType loc) const {
+		return m_Header->types[loc];
+	}
+	const EmdbLocation& Location(LocationType loc, uint16_t id) const {
+		return At<EmdbLocation>(m_Header->locationOffset)[Type(loc).first + id];
+	}
+	uint16_t Value(const EmdbSeed& seed, LocationType loc, uint16_t id) const {
+		return seed.Values()[Type(loc).first + id];
+	}
+
+	const EmdbSeed& Seed(const EmdbTerrain& terrain, uint32_t i) const {
+		return *At<EmdbSeed>(terrain.seedOffset + i * m_Header->seedStride);
+	}
+
+	const EmdbTree* FindTree(const EmdbTerrain& terrain, uint16_t spawn) const;
+	const EmdbTreeNode& TreeNode(uint32_t i) const {
+		return At<EmdbTreeNode>(m_Header->treeNodeOffset)[i];
+	}
+	const EmdbTreeBranch& TreeBranch(uint32_t i) const {
+		return At<EmdbTreeBranch>(m_Header->treeBranchOffset)[i];
+	}
+
+	// 编译所有地形的 json 数据为 .emdb 镜像，并生成识别决策树
+	// distanceWeight 为离落地点每 1000 像素额外计入的检查代价
+	static bool Compile(const std::vector<std::string_view>& terrains,
+		std::vector<char>& image, float distanceWeight = 0);
+
+private:
+	bool Attach(const char* data, size_t size);
+
+	template<class T>
+	const T* At(uint32_t offset) const {
+		return reinterpret_cast<const T*>(m_Data + offset);
+	}
+
+private:
+	const char* m_Data = nullptr;
+	const EmdbHeader* m_Header = nullptr;
+	std::vector<char> m_Image;
+	MappedFile m_File;
+};
+
+// json 源数据到 .emdb 镜像的编译器，地点文件经进程内缓存共享
+class SeedCompiler {
+public:
+	SeedCompiler();
+	bool IsValid() const {
+		return m_Valid;
+	}
+	// 流式解析种子数组，每个种子直接写入种子表的一条记录，不构建 DOM
+	bool LoadTerrain(std::string_view name);
+	void Finish(std::vector<char>& image) const;
+
+private:
+	struct SeedReader;
+
+	uint16_t Intern(std::string_view str);
+	void RehashStrings();
+	uint16_t FindLocation(LocationType loc, std::string_view name) const;
+
+private:
+	bool m_Valid = false;
+	std::deque<std::string> m_Strings;
+	// 开放寻址的字符串表，存放 id + 1，0 为空位；容量为 2 的幂且至多半满。
+	// 每个种子有数十个字段值要去重，unordered_map 的取模与链表访问是解析之外的主要开销
+	std::vector<uint16_t> m_StringSlots;
+	std::vector<size_t> m_StringHashes;
+
+	std::vector<EmdbLocation> m_Locations;
+	std::unordered_map<std::string_view, uint16_t> m_LocationIds[eLocationTypeCount];
+	EmdbLocationType m_Types[eLocationTypeCount]{};
+
+	uint32_t m_SeedStride = 0;
+	std::vector<EmdbTerrain> m_Terrains;
+	std::vector<char> m_SeedTable;
+
+	// 各地形的 map *.json 依次读入同一块缓冲并原地解析
+	std::vector<char> m_MapText;
+};
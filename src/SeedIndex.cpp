@@ -0,0 +1,175 @@
+#include "SeedIndex.h"
+#include <algorithm>
+
+SeedBitset::SeedBitset(uint32_t size, bool value) {
+    m_Size = size;
+    m_Words.assign((size + 63) / 64, value ? ~uint64_t(0) : 0);
+    if (value && (size & 63))
+        m_Words.back() = (uint64_t(1) << (size & 63)) - 1;
+}
+
+SeedBitset& SeedBitset::And(const uint64_t* words) {
+    uint64_t* dst = m_Words.data();
+    for (size_t i = 0, n = m_Words.size(); i < n; i++) {
+        dst[i] &= words[i];
+    }
+    return *this;
+}
+
+SeedBitset& SeedBitset::Or(const uint64_t* words) {
+    uint64_t* dst = m_Words.data();
+    for (size_t i = 0, n = m_Words.size(); i < n; i++) {
+        dst[i] |= words[i];
+    }
+    return *this;
+}
+
+SeedBitset& SeedBitset::AndNot(const uint64_t* words) {
+    uint64_t* dst = m_Words.data();
+    for (size_t i = 0, n = m_Words.size(); i < n; i++) {
+        dst[i] &= ~words[i];
+    }
+    return *this;
+}
+
+uint32_t SeedBitset::Count() const {
+    uint32_t count = 0;
+    for (uint64_t word : m_Words) {
+        count += PopCount(word);
+    }
+    return count;
+}
+
+uint32_t SeedBitset::CountAnd(const uint64_t* words) const {
+    uint32_t count = 0;
+    for (size_t i = 0, n = m_Words.size(); i < n; i++) {
+        count += PopCount(m_Words[i] & words[i]);
+    }
+    return count;
+}
+
+bool SeedBitset::Any() const {
+    uint64_t any = 0;
+    for (uint64_t word : m_Words) {
+        any |= word;
+    }
+    return any != 0;
+}
+
+bool SeedBitset::Intersects(const uint64_t* words) const {
+    uint64_t any = 0;
+    for (size_t i = 0, n = m_Words.size(); i < n; i++) {
+        any |= m_Words[i] & words[i];
+    }
+    return any != 0;
+}
+
+static const SeedFieldInfo SEED_FIELDS[eSeedFieldCount] = {
+    { "Nightlord", &EmdbSeed::nightlord, eLocationTypeCount },
+    { "Shifting Earth", &EmdbSeed::shifting_earth, eLocationTypeCount },
+    { "Special Event", &EmdbSeed::special_event, eLocationTypeCount },
+    { "Night 1 Boss", &EmdbSeed::night_1_boss, eLocationTypeCount },
+    { "Night 2 Boss", &EmdbSeed::night_2_boss, eLocationTypeCount },
+    { "Extra Night Boss", &EmdbSeed::extra_boss, eLocationTypeCount },
+    { "Castle", &EmdbSeed::castle_type, eLocationTypeCount },
+    { "Castle Basement", &EmdbSeed::castle_basement, eLocationTypeCount },
+    { "Castle Rooftop", &EmdbSeed::castle_rooftop, eLocationTypeCount },
+    { "Spawn Point", &EmdbSeed::spawn_point, eMinorBase },
+    { "Night 1 Circle", &EmdbSeed::night_1_circle, eCircle },
+    { "Night 2 Circle", &EmdbSeed::night_2_circle, eCircle },
+    { "Rot Blessing", &EmdbSeed::rot_blessing, eRotBlessing },
+    { "Frenzy Tower", &EmdbSeed::frenzy_tower, eFrenzyTower },
+    { "Scale-Bearing Merchant", &EmdbSeed::demon_merchant, eDemonMerchant },
+    { "Minor Base", nullptr, eMinorBase },
+    { "Major Base", nullptr, eMajorBase },
+    { "Evergaol", nullptr, eEvergaol },
+    { "Field Boss", nullptr, eFieldBoss },
+    { "Rotted Woods", nullptr, eRottedWoods },
+};
+
+const SeedFieldInfo& GetSeedFieldInfo(SeedField field) {
+    return SEED_FIELDS[field];
+}
+
+uint16_t GetSeedValue(const MapThumbnail& thumbnail, const EmdbSeed& seed,
+    SeedField field, uint16_t slot) {
+    const auto& info = SEED_FIELDS[field];
+    if (IsPerLocation(field))
+        return thumbnail.ValueOf(seed, info.location, slot);
+    return seed.*info.member;
+}
+
+void SeedIndex::Clear() {
+    m_SeedCount = 0;
+    m_WordCount = 0;
+    std::fill(std::begin(m_SlotCounts), std::end(m_SlotCounts), 0);
+    m_Words.clear();
+    m_Postings.clear();
+    m_Values.clear();
+}
+
+void SeedIndex::Build(const MapThumbnail& thumbnail) {
+    Clear();
+    m_SeedCount = thumbnail.SeedCount();
+    m_WordCount = (m_SeedCount + 63) / 64;
+    for (int f = 0; f < eSeedFieldCount; f++) {
+        auto field = (SeedField)f;
+        m_SlotCounts[f] = IsPerLocation(field)
+            ? thumbnail.LocationCount(SEED_FIELDS[field].location) : 1;
+    }
+
+    auto add = [this](SeedField field, uint16_t slot, uint16_t value, uint32_t i) {
+        auto key = Key(field, slot, value);
+        auto itr = m_Postings.find(key);
+        if (itr == m_Postings.end()) {
+            itr = m_Postings.emplace(key, (uint32_t)m_Words.size()).first;
+            m_Words.resize(m_Words.size() + m_WordCount, 0);
+            m_Values[(uint32_t(field) << 16) | slot].push_back(value);
+        }
+        m_Words[itr->second + (i >> 6)] |= uint64_t(1) << (i & 63);
+    };
+
+    for (uint32_t i = 0; i < m_SeedCount; i++) {
+        const auto& seed = thumbnail.Seed(i);
+        for (int f = 0; f < eSeedFieldCount; f++) {
+            auto field = (SeedField)f;
+            if (!IsPerLocation(field)) {
+                add(field, 0, GetSeedValue(thumbnail, seed, field, 0), i);
+                continue;
+            }
+            auto loc = SEED_FIELDS[field].location;
+            for (uint16_t slot = 0; slot < m_SlotCounts[field]; slot++) {
+                if (thumbnail.Query(loc, slot))
+                    add(field, slot, GetSeedValue(thumbnail, seed, field, slot), i);
+            }
+        }
+    }
+
+    for (auto& values : m_Values) {
+        std::sort(values.second.begin(), values.second.end());
+    }
+}
+
+const uint64_t* SeedIndex::Find(SeedField field, uint16_t slot, uint16_t value) const {
+    auto itr = m_Postings.find(Key(field, slot, value));
+    if (itr == m_Postings.end())
+        return nullptr;
+    return m_Words.data() + itr->second;
+}
+
+const std::vector<uint16_t>& SeedIndex::Values(SeedField field, uint16_t slot) const {
+    static const std::vector<uint16_t> empty;
+    auto itr = m_Values.find((uint32_t(field) << 16) | slot);
+    if (itr == m_Values.end())
+        return empty;
+    return itr->second;
+}
+
+void SeedIndex::Narrow(SeedBitset& candidates, SeedField field, uint16_t slot, uint16_t value) const {
+    auto words = Find(field, slot, value);
+    if (!words) {
+        candidates = SeedBitset(candidates.Size());
+        return;
+    }
+    candidates.And(words);
+}
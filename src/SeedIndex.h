@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "AssetUtils.h"
+
+inline uint32_t PopCount(uint64_t word) {
+#ifdef _MSC_VER
+	return (uint32_t)__popcnt64(word);
+#else
+	return (uint32_t)__builtin_popcountll(word);
+#endif
+}
+
+inline uint32_t TrailingZeros(uint64_t word) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(word);
+#endif
+}
+
+// 种子集合，每个种子在地形内的序号占一位
+// 按 64 位字做与或运算，循环保持简单以便编译器自动向量化
+class SeedBitset {
+public:
+	SeedBitset() = default;
+	explicit SeedBitset(uint32_t size, bool value = false);
+
+	uint32_t Size() const {
+		return m_Size;
+	}
+	uint32_t WordCount() const {
+		return (uint32_t)m_Words.size();
+	}
+	const uint64_t* Words() const {
+		return m_Words.data();
+	}
+	bool Test(uint32_t i) const {
+		return (m_Words[i >> 6] >> (i & 63)) & 1;
+	}
+	void Set(uint32_t i) {
+		m_Words[i >> 6] |= uint64_t(1) << (i & 63);
+	}
+
+	SeedBitset& And(const uint64_t* words);
+	SeedBitset& Or(const uint64_t* words);
+	SeedBitset& AndNot(const uint64_t* words);
+	SeedBitset& And(const SeedBitset& other) {
+		return And(other.Words());
+	}
+	SeedBitset& Or(const SeedBitset& other) {
+		return Or(other.Words());
+	}
+	SeedBitset& AndNot(const SeedBitset& other) {
+		return AndNot(other.Words());
+	}
+
+	uint32_t Count() const;
+	// 与 words 交集的种子数，不修改自身
+	uint32_t CountAnd(const uint64_t* words) const;
+	bool Any() const;
+	bool Intersects(const uint64_t* words) const;
+
+	template<class Func>
+	void Foreach(Func&& func) const {
+		for (uint32_t w = 0; w < m_Words.size(); w++) {
+			uint64_t word = m_Words[w];
+			while (word) {
+				func((w << 6) + TrailingZeros(word));
+				word &= word - 1;
+			}
+		}
+	}
+
+private:
+	std::vector<uint64_t> m_Words;
+	uint32_t m_Size = 0;
+};
+
+// 可检索的种子字段，标量字段在前，按地点取值的字段在后
+enum SeedField : uint8_t {
+	eSeedNightlord,
+	eSeedShiftingEarth,
+	eSeedSpecialEvent,
+	eSeedNight1Boss,
+	eSeedNight2Boss,
+	eSeedExtraBoss,
+	eSeedCastleType,
+	eSeedCastleBasement,
+	eSeedCastleRooftop,
+	eSeedSpawnPoint,
+	eSeedNight1Circle,
+	eSeedNight2Circle,
+	eSeedRotBlessing,
+	eSeedFrenzyTower,
+	eSeedDemonMerchant,
+	eSeedMinorBase,
+	eSeedMajorBase,
+	eSeedEvergaol,
+	eSeedFieldBoss,
+	eSeedRottedWoods,
+	eSeedFieldCount,
+};
+
+struct SeedFieldInfo {
+	const char* name;            // map *.json 中的字段名
+	uint16_t EmdbSeed::* member; // 标量字段，按地点取值的字段为空
+	LocationType location;       // 取值（或 slot）对应的地点类型，普通字符串为 eLocationTypeCount
+};
+
+const SeedFieldInfo& GetSeedFieldInfo(SeedField field);
+
+// 按地点取值的字段以地点 id 作 slot，其余字段 slot 为 0
+inline bool IsPerLocation(SeedField field) {
+	return field >= eSeedMinorBase;
+}
+
+// 字段取值：字符串字段为字符串 id，地点字段为地点 id
+uint16_t GetSeedValue(const MapThumbnail& thumbnail, const EmdbSeed& seed,
+	SeedField field, uint16_t slot);
+
+// 单个地形的倒排索引：(字段, slot, 取值) -> 种子集合
+class SeedIndex {
+public:
+	void Build(const MapThumbnail& thumbnail);
+	void Clear();
+
+	uint32_t SeedCount() const {
+		return m_SeedCount;
+	}
+	SeedBitset All() const {
+		return SeedBitset(m_SeedCount, true);
+	}
+	// 不存在的组合返回空
+	const uint64_t* Find(SeedField field, uint16_t slot, uint16_t value) const;
+	// 该字段在此地形出现过的全部取值（升序）
+	const std::vector<uint16_t>& Values(SeedField field, uint16_t slot) const;
+	// 标量字段为 1，按地点取值的字段为该地点类型的地点数
+	uint16_t SlotCount(SeedField field) const {
+		return m_SlotCounts[field];
+	}
+
+	// candidates 与 (字段, slot, 取值) 求交
+	void Narrow(SeedBitset& candidates, SeedField field, uint16_t slot, uint16_t value) const;
+
+private:
+	static uint64_t Key(SeedField field, uint16_t slot, uint16_t value) {
+		return (uint64_t(field) << 32) | (uint64_t(slot) << 16) | value;
+	}
+
+private:
+	uint32_t m_SeedCount = 0;
+	uint32_t m_WordCount = 0;
+	uint16_t m_SlotCounts[eSeedFieldCount]{};
+	std::vector<uint64_t> m_Words;
+	std::unordered_map<uint64_t, uint32_t> m_Postings;
+	std::unordered_map<uint32_t, std::vector<uint16_t>> m_Values;
+};
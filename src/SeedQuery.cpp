@@ -0,0 +1,72 @@
+#include "SeedQuery.h"
+#include <algorithm>
+
+const SeedHistogram* SeedQueryResult::Histogram(SeedField field, uint16_t slot) const {
+    auto itr = std::find_if(histograms.begin(), histograms.end(),
+        [field, slot](const SeedHistogram& histogram) {
+            return histogram.field == field && histogram.slot == slot;
+        });
+    return itr == histograms.end() ? nullptr : &*itr;
+}
+
+SeedQuery& SeedQuery::Remove(SeedField field, uint16_t slot) {
+    auto itr = std::remove_if(m_Constraints.begin(), m_Constraints.end(),
+        [field, slot](const SeedConstraint& constraint) {
+            return constraint.field == field && constraint.slot == slot;
+        });
+    m_Constraints.erase(itr, m_Constraints.end());
+    return *this;
+}
+
+SeedBitset SeedQuery::Match(const SeedIndex& index) const {
+    SeedBitset candidates = index.All();
+    for (const auto& constraint : m_Constraints) {
+        bool anySlot = constraint.slot == SEED_ANY_SLOT && IsPerLocation(constraint.field);
+        if (!anySlot && constraint.values.size() == 1) {
+            index.Narrow(candidates, constraint.field, constraint.slot, constraint.values[0]);
+            continue;
+        }
+
+        uint16_t first = anySlot ? 0 : constraint.slot;
+        uint16_t last = anySlot ? index.SlotCount(constraint.field) : first + 1;
+        SeedBitset matched(index.SeedCount());
+        for (uint16_t slot = first; slot < last; slot++) {
+            for (uint16_t value : constraint.values) {
+                if (auto words = index.Find(constraint.field, slot, value))
+                    matched.Or(words);
+            }
+        }
+        candidates.And(matched);
+    }
+    return candidates;
+}
+
+SeedQueryResult SeedQuery::Run(const SeedIndex& index, bool histograms) const {
+    SeedQueryResult result;
+    result.candidates = Match(index);
+    result.seeds.reserve(result.candidates.Count());
+    result.candidates.Foreach([&result](uint32_t i) {
+        result.seeds.push_back(i);
+    });
+    if (histograms)
+        Histograms(index, result.candidates, result.histograms);
+    return result;
+}
+
+void SeedQuery::Histograms(const SeedIndex& index, const SeedBitset& candidates,
+    std::vector<SeedHistogram>& result) {
+    result.clear();
+    for (int f = 0; f < eSeedFieldCount; f++) {
+        auto field = (SeedField)f;
+        for (uint16_t slot = 0; slot < index.SlotCount(field); slot++) {
+            SeedHistogram histogram{ field, slot, {} };
+            for (uint16_t value : index.Values(field, slot)) {
+                uint32_t count = candidates.CountAnd(index.Find(field, slot, value));
+                if (count > 0)
+                    histogram.counts.emplace_back(value, count);
+            }
+            if (!histogram.counts.empty())
+                result.push_back(std::move(histogram));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "SeedIndex.h"
+
+// 任意位置，仅对按地点取值的字段有效，如"某处 Major Base 为 Fort"
+constexpr uint16_t SEED_ANY_SLOT = 0xFFFF;
+
+// 单个约束：字段在 slot 处取 values 中任意一个
+struct SeedConstraint {
+	SeedField field;
+	uint16_t slot = 0;
+	std::vector<uint16_t> values;
+};
+
+struct SeedHistogram {
+	SeedField field;
+	uint16_t slot = 0;
+	// (取值, 剩余候选中的种子数)，只含非零项
+	std::vector<std::pair<uint16_t, uint32_t>> counts;
+};
+
+struct SeedQueryResult {
+	SeedBitset candidates;
+	// 匹配种子在地形内的序号
+	std::vector<uint32_t> seeds;
+	std::vector<SeedHistogram> histograms;
+
+	const SeedHistogram* Histogram(SeedField field, uint16_t slot = 0) const;
+};
+
+// 与界面无关的多约束种子查询，约束之间为与关系
+class SeedQuery {
+public:
+	SeedQuery& Where(SeedField field, uint16_t value) {
+		return Where(field, 0, value);
+	}
+	SeedQuery& Where(SeedField field, uint16_t slot, uint16_t value) {
+		m_Constraints.push_back({ field, slot, { value } });
+		return *this;
+	}
+	SeedQuery& WhereAny(SeedField field, uint16_t slot, std::vector<uint16_t> values) {
+		m_Constraints.push_back({ field, slot, std::move(values) });
+		return *this;
+	}
+	// 移除该字段与 slot 上的全部约束
+	SeedQuery& Remove(SeedField field, uint16_t slot = 0);
+	void Clear() {
+		m_Constraints.clear();
+	}
+	bool Empty() const {
+		return m_Constraints.empty();
+	}
+	const std::vector<SeedConstraint>& Constraints() const {
+		return m_Constraints;
+	}
+
+	SeedBitset Match(const SeedIndex& index) const;
+	SeedQueryResult Run(const SeedIndex& index, bool histograms = true) const;
+
+	// 候选集合上每个 (字段, slot) 的取值分布
+	static void Histograms(const SeedIndex& index, const SeedBitset& candidates,
+		std::vector<SeedHistogram>& result);
+
+private:
+	std::vector<SeedConstraint> m_Constraints;
+};
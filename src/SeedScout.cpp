@@ -0,0 +1,98 @@
+#include "SeedScout.h"
+#include <algorithm>
+#include <cmath>
+
+void SeedScout::Clear() {
+    m_Index = nullptr;
+    m_Candidates = SeedBitset();
+    m_CandidateCount = 0;
+    m_Slots.clear();
+    m_Suggestions.clear();
+}
+
+void SeedScout::Reset(const SeedIndex& index, const SeedBitset& candidates) {
+    Clear();
+    m_Index = &index;
+    m_Candidates = candidates;
+    for (int f = eSeedMinorBase; f < eSeedFieldCount; f++) {
+        auto field = (SeedField)f;
+        for (uint16_t slot = 0; slot < index.SlotCount(field); slot++) {
+            const auto& values = index.Values(field, slot);
+            if (values.size() < 2)
+                continue;
+            Slot target{ field, slot };
+            for (uint16_t value : values) {
+                target.values.push_back(value);
+                target.postings.push_back(index.Find(field, slot, value));
+            }
+            m_Slots.push_back(std::move(target));
+        }
+    }
+    Refresh();
+}
+
+void SeedScout::Observe(SeedField field, uint16_t slot, uint16_t value) {
+    if (!m_Index)
+        return;
+    m_Index->Narrow(m_Candidates, field, slot, value);
+    auto itr = std::remove_if(m_Slots.begin(), m_Slots.end(),
+        [field, slot](const Slot& target) {
+            return target.field == field && target.slot == slot;
+        });
+    m_Slots.erase(itr, m_Slots.end());
+    Refresh();
+}
+
+const std::vector<uint16_t>& SeedScout::Values(SeedField field, uint16_t slot) const {
+    static const std::vector<uint16_t> empty;
+    for (const auto& target : m_Slots) {
+        if (target.field == field && target.slot == slot)
+            return target.values;
+    }
+    return empty;
+}
+
+void SeedScout::Refresh() {
+    m_Suggestions.clear();
+    m_CandidateCount = m_Candidates.Count();
+    if (m_CandidateCount < 2) {
+        m_Slots.clear();
+        return;
+    }
+
+    float total = (float)m_CandidateCount;
+    size_t alive = 0;
+    for (size_t s = 0; s < m_Slots.size(); s++) {
+        auto& target = m_Slots[s];
+        float entropy = 0, expected = 0;
+        size_t kept = 0;
+        for (size_t v = 0; v < target.values.size(); v++) {
+            uint32_t count = m_Candidates.CountAnd(target.postings[v]);
+            if (count == 0)
+                continue;
+            float p = count / total;
+            entropy -= p * std::log2(p);
+            expected += p * count;
+            target.values[kept] = target.values[v];
+            target.postings[kept] = target.postings[v];
+            kept++;
+        }
+        target.values.resize(kept);
+        target.postings.resize(kept);
+        // 只剩一种取值的地点不再提供信息
+        if (kept < 2)
+            continue;
+        m_Suggestions.push_back({ target.field, target.slot, entropy, expected });
+        if (alive != s)
+            m_Slots[alive] = std::move(target);
+        alive++;
+    }
+    m_Slots.resize(alive);
+
+    std::sort(m_Suggestions.begin(), m_Suggestions.end(),
+        [](const ScoutSuggestion& l, const ScoutSuggestion& r) {
+            if (l.entropy != r.entropy)
+                return l.entropy > r.entropy;
+            return l.expected < r.expected;
+        });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "SeedIndex.h"
+
+// 侦察某个地点的收益
+struct ScoutSuggestion {
+	SeedField field;
+	uint16_t slot = 0;
+	// 该地点取值在候选种子上的熵（比特），越大越能区分种子
+	float entropy = 0;
+	// 侦察后期望剩余的候选种子数
+	float expected = 0;
+};
+
+// "下一步去看哪里"：按信息增益给未观察的地点排序
+// 候选集合只会缩小，已无区分度的地点与已不可能的取值会被永久剔除，
+// 每次观察只重算剩余部分
+class SeedScout {
+public:
+	void Reset(const SeedIndex& index, const SeedBitset& candidates);
+	void Clear();
+
+	// 观察到 (字段, slot) 处为 value，缩小候选并刷新排序
+	void Observe(SeedField field, uint16_t slot, uint16_t value);
+
+	const SeedBitset& Candidates() const {
+		return m_Candidates;
+	}
+	uint32_t CandidateCount() const {
+		return m_CandidateCount;
+	}
+	// 按熵降序
+	const std::vector<ScoutSuggestion>& Suggestions() const {
+		return m_Suggestions;
+	}
+	// 该地点在剩余候选中仍可能出现的取值
+	const std::vector<uint16_t>& Values(SeedField field, uint16_t slot) const;
+
+private:
+	struct Slot {
+		SeedField field;
+		uint16_t slot;
+		std::vector<uint16_t> values;
+		std::vector<const uint64_t*> postings;
+	};
+
+	void Refresh();
+
+private:
+	const SeedIndex* m_Index = nullptr;
+	SeedBitset m_Candidates;
+	uint32_t m_CandidateCount = 0;
+	std::vector<Slot> m_Slots;
+	std::vector<ScoutSuggestion> m_Suggestions;
+};
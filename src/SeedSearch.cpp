@@ -0,0 +1,58 @@
+#include "SeedSearch.h"
+#include <algorithm>
+
+#include "Profiler.h"
+
+bool SeedSearch::Load(const SeedDatabase& database, const std::vector<std::string_view>& terrains) {
+    PROFILE_SCOPE("SeedSearch::Load");
+    Clear();
+    m_Terrains.resize(terrains.size());
+    uint32_t loaded = 0;
+    for (size_t i = 0; i < terrains.size(); i++) {
+        auto& terrain = m_Terrains[loaded];
+        terrain.name = terrains[i];
+        if (!terrain.thumbnail.LoadMap(database, std::string(terrains[i]).c_str()))
+            continue;
+        terrain.index.Build(terrain.thumbnail);
+        loaded++;
+    }
+    m_Terrains.resize(loaded);
+    // 调用线程也参与求值，地形数减一个工作线程即可一轮完成
+    unsigned threads = std::min(std::max(1u, std::thread::hardware_concurrency()), loaded);
+    m_Pool.Start(threads > 0 ? threads - 1 : 0);
+    return loaded > 0;
+}
+
+void SeedSearch::Clear() {
+    m_Pool.Stop();
+    m_Terrains.clear();
+}
+
+std::vector<uint16_t> SeedSearch::Values(SeedField field, uint16_t slot) const {
+    std::vector<uint16_t> result;
+    for (const auto& terrain : m_Terrains) {
+        const auto& values = terrain.index.Values(field, slot);
+        result.insert(result.end(), values.begin(), values.end());
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void SeedSearch::Run(const SeedQuery& query, std::vector<SeedMatch>& result) {
+    PROFILE_SCOPE("SeedSearch::Run");
+    m_Pool.ParallelFor(TerrainCount(), [this, &query](uint32_t i) {
+        auto& terrain = m_Terrains[i];
+        terrain.seeds.clear();
+        query.Match(terrain.index).Foreach([&terrain](uint32_t seed) {
+            terrain.seeds.push_back(seed);
+        });
+    });
+
+    result.clear();
+    for (uint32_t i = 0; i < TerrainCount(); i++) {
+        for (uint32_t seed : m_Terrains[i].seeds) {
+            result.push_back({ (uint16_t)i, seed });
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "SeedQuery.h"
+#include "ThreadPool.h"
+
+struct SeedMatch {
+	uint16_t terrain; // SeedSearch 中的地形序号
+	uint32_t seed;    // 种子在地形内的序号
+};
+
+// 跨地形的种子搜索：同时载入全部地形的索引，同一查询在线程池中对各地形并发求值，
+// 结果按地形顺序合并并标注地形。字符串与地点 id 在 .emdb 中全局唯一，查询无需按地形转换
+class SeedSearch {
+public:
+	bool Load(const SeedDatabase& database, const std::vector<std::string_view>& terrains);
+	void Clear();
+
+	uint32_t TerrainCount() const {
+		return (uint32_t)m_Terrains.size();
+	}
+	std::string_view TerrainName(uint32_t terrain) const {
+		return m_Terrains[terrain].name;
+	}
+	const MapThumbnail& Thumbnail(uint32_t terrain) const {
+		return m_Terrains[terrain].thumbnail;
+	}
+	const SeedIndex& Index(uint32_t terrain) const {
+		return m_Terrains[terrain].index;
+	}
+	// 各地形出现过的取值的并集（升序）
+	std::vector<uint16_t> Values(SeedField field, uint16_t slot = 0) const;
+
+	void Run(const SeedQuery& query, std::vector<SeedMatch>& result);
+	// 最近一次 Run 在该地形上的匹配数
+	uint32_t MatchCount(uint32_t terrain) const {
+		return (uint32_t)m_Terrains[terrain].seeds.size();
+	}
+
+private:
+	struct Terrain {
+		std::string_view name;
+		MapThumbnail thumbnail;
+		SeedIndex index;
+		std::vector<uint32_t> seeds;
+	};
+
+	std::vector<Terrain> m_Terrains;
+	ThreadPool m_Pool;
+};
@@ -0,0 +1,242 @@
+#include "SeedSimilarity.h"
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
+
+// k-medoids 的最大迭代次数，种子数很少，通常几轮内收敛
+static constexpr int CLUSTER_ITERATIONS = 32;
+
+void SeedSimilarity::Clear() {
+    m_Index = nullptr;
+    m_SeedCount = 0;
+    m_FeatureCount = 0;
+    m_BitCount = 0;
+    m_WordCount = 0;
+    m_Features.clear();
+    m_Vectors.clear();
+}
+
+void SeedSimilarity::Build(const SeedIndex& index) {
+    Clear();
+    m_Index = &index;
+    m_SeedCount = index.SeedCount();
+    for (int f = 0; f < eSeedFieldCount; f++) {
+        auto field = (SeedField)f;
+        for (uint16_t slot = 0; slot < index.SlotCount(field); slot++) {
+            const auto& values = index.Values(field, slot);
+            if (values.empty())
+                continue;
+            m_Features.emplace(FeatureKey(field, slot), Feature{ m_BitCount, &values });
+            m_BitCount += (uint32_t)values.size();
+            m_FeatureCount++;
+        }
+    }
+    m_WordCount = (m_BitCount + 63) / 64;
+
+    // 由倒排表转置得到每个种子的位向量
+    m_Vectors.assign(size_t(m_SeedCount) * m_WordCount, 0);
+    for (const auto& entry : m_Features) {
+        auto field = (SeedField)(entry.first >> 16);
+        auto slot = (uint16_t)(entry.first & 0xFFFF);
+        const auto& feature = entry.second;
+        for (size_t i = 0; i < feature.values->size(); i++) {
+            uint32_t bit = feature.firstBit + (uint32_t)i;
+            SeedBitset seeds(m_SeedCount);
+            seeds.Or(index.Find(field, slot, (*feature.values)[i]));
+            seeds.Foreach([this, bit](uint32_t seed) {
+                m_Vectors[size_t(seed) * m_WordCount + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+            });
+        }
+    }
+}
+
+uint32_t SeedSimilarity::Bit(SeedField field, uint16_t slot, uint16_t value) const {
+    auto itr = m_Features.find(FeatureKey(field, slot));
+    if (itr == m_Features.end())
+        return UINT32_MAX;
+    const auto& values = *itr->second.values;
+    auto found = std::lower_bound(values.begin(), values.end(), value);
+    if (found == values.end() || *found != value)
+        return UINT32_MAX;
+    return itr->second.firstBit + (uint32_t)(found - values.begin());
+}
+
+uint32_t SeedSimilarity::Distance(uint32_t a, uint32_t b) const {
+    const uint64_t* x = Vector(a);
+    const uint64_t* y = Vector(b);
+    uint32_t bits = 0;
+    for (uint32_t w = 0; w < m_WordCount; w++) {
+        bits += PopCount(x[w] ^ y[w]);
+    }
+    return bits / 2;
+}
+
+uint32_t SeedSimilarity::Matches(uint32_t seed, const uint64_t* words) const {
+    const uint64_t* x = Vector(seed);
+    uint32_t bits = 0;
+    for (uint32_t w = 0; w < m_WordCount; w++) {
+        bits += PopCount(x[w] & words[w]);
+    }
+    return bits;
+}
+
+void SeedSimilarity::Select(std::vector<SeedDistance>& all, uint32_t count,
+    std::vector<SeedDistance>& result) {
+    auto less = [](const SeedDistance& l, const SeedDistance& r) {
+        return l.distance != r.distance ? l.distance < r.distance : l.seed < r.seed;
+    };
+    count = std::min(count, (uint32_t)all.size());
+    std::partial_sort(all.begin(), all.begin() + count, all.end(), less);
+    result.assign(all.begin(), all.begin() + count);
+}
+
+void SeedSimilarity::Nearest(uint32_t seed, uint32_t count, std::vector<SeedDistance>& result) const {
+    std::vector<SeedDistance> all;
+    all.reserve(m_SeedCount);
+    for (uint32_t i = 0; i < m_SeedCount; i++) {
+        if (i != seed)
+            all.push_back({ i, Distance(seed, i) });
+    }
+    Select(all, count, result);
+}
+
+void SeedSimilarity::Nearest(const SeedQuery& query, uint32_t count, std::vector<SeedDistance>& result) const {
+    // 单个地点的约束合并为一个掩码：种子在每个 (字段, slot) 上只有一位，
+    // 与掩码相与后的位数即满足的 (字段, slot) 数
+    std::vector<uint64_t> observed(m_WordCount, 0);
+    std::unordered_set<uint32_t> features;
+    uint32_t penalty = 0; // 地形中不存在的地点，任何种子都不满足
+    // 任意地点的约束，满足其中任意一位即可
+    std::vector<std::vector<uint64_t>> anySlots;
+
+    auto set = [](std::vector<uint64_t>& words, uint32_t bit) {
+        if (bit != UINT32_MAX)
+            words[bit >> 6] |= uint64_t(1) << (bit & 63);
+    };
+    for (const auto& constraint : query.Constraints()) {
+        auto field = constraint.field;
+        if (constraint.slot == SEED_ANY_SLOT && IsPerLocation(field)) {
+            auto& words = anySlots.emplace_back(m_WordCount, 0);
+            for (uint16_t slot = 0; slot < m_Index->SlotCount(field); slot++) {
+                for (uint16_t value : constraint.values) {
+                    set(words, Bit(field, slot, value));
+                }
+            }
+            continue;
+        }
+        if (constraint.slot >= m_Index->SlotCount(field)) {
+            penalty++;
+            continue;
+        }
+        features.insert(FeatureKey(field, constraint.slot));
+        for (uint16_t value : constraint.values) {
+            set(observed, Bit(field, constraint.slot, value));
+        }
+    }
+
+    std::vector<SeedDistance> all(m_SeedCount);
+    for (uint32_t i = 0; i < m_SeedCount; i++) {
+        uint32_t distance = penalty + (uint32_t)features.size() - Matches(i, observed.data());
+        for (const auto& words : anySlots) {
+            distance += Matches(i, words.data()) == 0;
+        }
+        all[i] = { i, distance };
+    }
+    Select(all, count, result);
+}
+
+void SeedSimilarity::Cluster(uint32_t count, std::vector<SeedCluster>& clusters) const {
+    clusters.clear();
+    uint32_t n = m_SeedCount;
+    count = std::min(count, n);
+    if (count == 0)
+        return;
+
+    std::vector<uint16_t> distances(size_t(n) * n);
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = i; j < n; j++) {
+            uint16_t d = (uint16_t)Distance(i, j);
+            distances[size_t(i) * n + j] = d;
+            distances[size_t(j) * n + i] = d;
+        }
+    }
+    auto dist = [&distances, n](uint32_t i, uint32_t j) {
+        return (uint32_t)distances[size_t(i) * n + j];
+    };
+
+    // 以全体的 medoid 开始，依次加入离已选 medoid 最远的种子
+    std::vector<uint32_t> medoids;
+    {
+        uint32_t best = 0;
+        uint64_t bestSum = UINT64_MAX;
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t sum = 0;
+            for (uint32_t j = 0; j < n; j++) {
+                sum += dist(i, j);
+            }
+            if (sum < bestSum)
+                best = i, bestSum = sum;
+        }
+        medoids.push_back(best);
+    }
+    std::vector<uint32_t> nearest(n);
+    for (uint32_t i = 0; i < n; i++) {
+        nearest[i] = dist(i, medoids[0]);
+    }
+    while (medoids.size() < count) {
+        uint32_t far = 0;
+        for (uint32_t i = 1; i < n; i++) {
+            if (nearest[i] > nearest[far])
+                far = i;
+        }
+        medoids.push_back(far);
+        for (uint32_t i = 0; i < n; i++) {
+            nearest[i] = std::min(nearest[i], dist(i, far));
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> members(count);
+    for (int iteration = 0; iteration < CLUSTER_ITERATIONS; iteration++) {
+        for (auto& seeds : members) {
+            seeds.clear();
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t best = 0;
+            for (uint32_t c = 1; c < count; c++) {
+                if (dist(i, medoids[c]) < dist(i, medoids[best]))
+                    best = c;
+            }
+            members[best].push_back(i);
+        }
+
+        bool changed = false;
+        for (uint32_t c = 0; c < count; c++) {
+            uint32_t best = medoids[c];
+            uint64_t bestSum = UINT64_MAX;
+            for (uint32_t i : members[c]) {
+                uint64_t sum = 0;
+                for (uint32_t j : members[c]) {
+                    sum += dist(i, j);
+                }
+                if (sum < bestSum || (sum == bestSum && i < best))
+                    best = i, bestSum = sum;
+            }
+            changed = changed || best != medoids[c];
+            medoids[c] = best;
+        }
+        if (!changed)
+            break;
+    }
+
+    clusters.resize(count);
+    for (uint32_t c = 0; c < count; c++) {
+        auto& cluster = clusters[c];
+        cluster.medoid = medoids[c];
+        cluster.seeds = std::move(members[c]);
+        uint64_t sum = 0;
+        for (uint32_t i : cluster.seeds) {
+            sum += dist(i, cluster.medoid);
+        }
+        cluster.spread = cluster.seeds.empty() ? 0.f : (float)sum / cluster.seeds.size();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "SeedQuery.h"
+
+struct SeedDistance {
+	uint32_t seed;     // 种子在地形内的序号
+	uint32_t distance; // 取值不同的 (字段, slot) 数
+};
+
+struct SeedCluster {
+	uint32_t medoid; // 到簇内其余种子距离之和最小的种子
+	std::vector<uint32_t> seeds;
+	float spread = 0; // 簇内种子到 medoid 的平均距离
+};
+
+// 种子的定长位向量编码：每个 (字段, slot) 按 SeedIndex 中的取值 one-hot 占一段位，
+// 两个种子的汉明距离的一半即取值不同的 (字段, slot) 数。
+// 距离只需逐字 xor / and 后 popcount，循环保持简单以便编译器自动向量化
+class SeedSimilarity {
+public:
+	void Build(const SeedIndex& index);
+	void Clear();
+
+	uint32_t SeedCount() const {
+		return m_SeedCount;
+	}
+	// 编码的 (字段, slot) 数，即两个种子间的最大距离
+	uint32_t FeatureCount() const {
+		return m_FeatureCount;
+	}
+	uint32_t BitCount() const {
+		return m_BitCount;
+	}
+	const uint64_t* Vector(uint32_t seed) const {
+		return m_Vectors.data() + size_t(seed) * m_WordCount;
+	}
+
+	uint32_t Distance(uint32_t a, uint32_t b) const;
+	// 与 seed 最相似的 count 个种子（不含自身），按距离升序，距离相同时按序号
+	void Nearest(uint32_t seed, uint32_t count, std::vector<SeedDistance>& result) const;
+	// 与观察结果最接近的 count 个种子，距离为不满足的约束数。
+	// 观察互相矛盾或有误、没有种子完全匹配时仍能给出最可能的种子
+	void Nearest(const SeedQuery& query, uint32_t count, std::vector<SeedDistance>& result) const;
+
+	// k-medoids 聚类，medoid 以最远点法初始化，结果确定
+	void Cluster(uint32_t count, std::vector<SeedCluster>& clusters) const;
+
+private:
+	struct Feature {
+		uint32_t firstBit;
+		const std::vector<uint16_t>* values; // 升序，第 i 个取值对应 firstBit + i
+	};
+
+	static uint32_t FeatureKey(SeedField field, uint16_t slot) {
+		return (uint32_t(field) << 16) | slot;
+	}
+	// 不存在的 (字段, slot, 取值) 返回 UINT32_MAX
+	uint32_t Bit(SeedField field, uint16_t slot, uint16_t value) const;
+	uint32_t Matches(uint32_t seed, const uint64_t* words) const;
+	static void Select(std::vector<SeedDistance>& all, uint32_t count,
+		std::vector<SeedDistance>& result);
+
+private:
+	const SeedIndex* m_Index = nullptr;
+	uint32_t m_SeedCount = 0;
+	uint32_t m_FeatureCount = 0;
+	uint32_t m_BitCount = 0;
+	uint32_t m_WordCount = 0;
+	std::unordered_map<uint32_t, Feature> m_Features;
+	std::vector<uint64_t> m_Vectors;
+};
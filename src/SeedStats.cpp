@@ -0,0 +1,98 @@
+#include "SeedStats.h"
+#include <algorithm>
+
+void SeedStats::Clear() {
+    m_Index = nullptr;
+    m_Slots.clear();
+    m_Values.clear();
+    m_Postings.clear();
+    m_Counts.clear();
+    m_Columns.clear();
+    m_SeedCount = 0;
+    m_Candidates = SeedBitset();
+    m_CandidateCount = 0;
+}
+
+void SeedStats::Reset(const SeedIndex& index, const std::vector<SeedField>& fields) {
+    Clear();
+    m_Index = &index;
+    m_SeedCount = index.SeedCount();
+    for (auto field : fields) {
+        for (uint16_t slot = 0; slot < index.SlotCount(field); slot++) {
+            const auto& values = index.Values(field, slot);
+            if (values.empty())
+                continue;
+            m_Slots.push_back({ field, slot, (uint32_t)m_Values.size(), (uint32_t)values.size() });
+            for (uint16_t value : values) {
+                m_Values.push_back(value);
+                m_Postings.push_back(index.Find(field, slot, value));
+            }
+        }
+    }
+    m_Counts.assign(m_Values.size(), 0);
+
+    // 由倒排表转置出按种子的列
+    m_Columns.assign(m_Slots.size() * m_SeedCount, 0);
+    for (uint32_t s = 0; s < m_Slots.size(); s++) {
+        const auto& slot = m_Slots[s];
+        uint16_t* column = m_Columns.data() + size_t(s) * m_SeedCount;
+        for (uint32_t i = 0; i < slot.count; i++) {
+            SeedBitset seeds(m_SeedCount);
+            seeds.Or(m_Postings[slot.first + i]);
+            seeds.Foreach([column, i](uint32_t seed) {
+                column[seed] = (uint16_t)i;
+            });
+        }
+    }
+    m_Candidates = SeedBitset(m_SeedCount);
+}
+
+uint32_t SeedStats::Update(const SeedBitset& candidates) {
+    if (!m_Index || candidates.Size() != m_SeedCount)
+        return 0;
+
+    SeedBitset added = candidates;
+    added.AndNot(m_Candidates);
+    SeedBitset removed = m_Candidates;
+    removed.AndNot(candidates);
+    uint32_t changed = added.Count() + removed.Count();
+    if (changed == 0)
+        return 0;
+
+    // 逐个种子更新每个 slot 一次，整体重算每个取值扫描一遍位图，取代价较小的一种
+    uint64_t incremental = uint64_t(changed) * m_Slots.size();
+    uint64_t recount = uint64_t(m_Values.size()) * candidates.WordCount();
+    if (incremental < recount) {
+        auto apply = [this](uint32_t seed, int delta) {
+            for (uint32_t s = 0; s < m_Slots.size(); s++) {
+                uint16_t value = m_Columns[size_t(s) * m_SeedCount + seed];
+                m_Counts[m_Slots[s].first + value] += delta;
+            }
+        };
+        added.Foreach([&apply](uint32_t seed) { apply(seed, 1); });
+        removed.Foreach([&apply](uint32_t seed) { apply(seed, -1); });
+    }
+    else {
+        for (size_t i = 0; i < m_Values.size(); i++) {
+            m_Counts[i] = candidates.CountAnd(m_Postings[i]);
+        }
+    }
+
+    m_Candidates = candidates;
+    m_CandidateCount = candidates.Count();
+    return changed;
+}
+
+void SeedStats::Histogram(const Slot& slot, SeedHistogram& result) const {
+    result.field = slot.field;
+    result.slot = slot.slot;
+    result.counts.clear();
+    for (uint32_t i = 0; i < slot.count; i++) {
+        if (uint32_t count = Count(slot, i))
+            result.counts.emplace_back(Value(slot, i), count);
+    }
+    std::stable_sort(result.counts.begin(), result.counts.end(),
+        [](const std::pair<uint16_t, uint32_t>& l, const std::pair<uint16_t, uint32_t>& r) {
+            return l.second > r.second;
+        });
+}
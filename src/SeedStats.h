@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "SeedQuery.h"
+
+// 候选集合上各 (字段, slot) 的取值分布。
+// 候选集合变化较少时按列存的取值只对增加与移除的种子增减计数，增删约束都不必整体重算；
+// 变化较多时按 SeedIndex 的倒排位图整体重新计数
+class SeedStats {
+public:
+	struct Slot {
+		SeedField field;
+		uint16_t slot;
+		uint32_t first; // 在取值与计数数组中的起始位置
+		uint32_t count; // 取值数
+	};
+
+	// 统计 fields 中各字段在此地形出现过的全部 slot，候选集合为空
+	void Reset(const SeedIndex& index, const std::vector<SeedField>& fields);
+	void Clear();
+	// 换成新的候选集合，返回计数有变化的种子数
+	uint32_t Update(const SeedBitset& candidates);
+
+	uint32_t CandidateCount() const {
+		return m_CandidateCount;
+	}
+	uint32_t SlotCount() const {
+		return (uint32_t)m_Slots.size();
+	}
+	const Slot& GetSlot(uint32_t i) const {
+		return m_Slots[i];
+	}
+	uint16_t Value(const Slot& slot, uint32_t i) const {
+		return m_Values[slot.first + i];
+	}
+	uint32_t Count(const Slot& slot, uint32_t i) const {
+		return m_Counts[slot.first + i];
+	}
+	// 按种子数降序的非零分布
+	void Histogram(const Slot& slot, SeedHistogram& result) const;
+
+private:
+	const SeedIndex* m_Index = nullptr;
+	std::vector<Slot> m_Slots;
+	std::vector<uint16_t> m_Values;
+	std::vector<const uint64_t*> m_Postings;
+	std::vector<uint32_t> m_Counts;
+	// 每个 slot 一列，按种子序号存取值在该 slot 取值中的序号
+	std::vector<uint16_t> m_Columns;
+	uint32_t m_SeedCount = 0;
+	SeedBitset m_Candidates;
+	uint32_t m_CandidateCount = 0;
+};
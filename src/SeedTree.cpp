@@ -0,0 +1,235 @@
+#include "SeedTree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <set>
+
+#include "LogUtils.h"
+
+SeedField GetLocationField(LocationType loc) {
+    for (int f = eSeedMinorBase; f < eSeedFieldCount; f++) {
+        if (GetSeedFieldInfo((SeedField)f).location == loc)
+            return (SeedField)f;
+    }
+    return eSeedFieldCount;
+}
+
+void SeedTreeBuilder::Build(const MapThumbnail& thumbnail, const SeedIndex& index,
+    uint32_t terrain) {
+    for (uint16_t spawn : index.Values(eSeedSpawnPoint, 0)) {
+        auto spawnPos = thumbnail.Query(eMinorBase, spawn);
+        if (!spawnPos)
+            continue;
+
+        m_Seeds.clear();
+        auto candidates = index.All();
+        index.Narrow(candidates, eSeedSpawnPoint, 0, spawn);
+        candidates.Foreach([this](uint32_t i) {
+            m_Seeds.push_back((uint16_t)i);
+        });
+        if (m_Seeds.size() > 64) {
+            LogInfo("Too many seeds for spawn %s\n", thumbnail.Name(eMinorBase, spawn));
+            continue;
+        }
+
+        // 每个可检查的地点在本落地点种子上的划分
+        m_Checks.clear();
+        m_MinCost = FLT_MAX;
+        for (int f = eSeedMinorBase; f < eSeedFieldCount; f++) {
+            auto field = (SeedField)f;
+            auto loc = GetSeedFieldInfo(field).location;
+            for (uint16_t slot = 0; slot < index.SlotCount(field); slot++) {
+                auto pos = thumbnail.Query(loc, slot);
+                if (!pos)
+                    continue;
+                Check check{ loc, slot };
+                check.cost = 1 + m_DistanceWeight
+                    * glm::distance(glm::vec2(*spawnPos), glm::vec2(*pos)) / 1000.f;
+                for (size_t i = 0; i < m_Seeds.size(); i++) {
+                    auto value = GetSeedValue(thumbnail, thumbnail.Seed(m_Seeds[i]), field, slot);
+                    auto itr = std::find_if(check.parts.begin(), check.parts.end(),
+                        [value](const std::pair<uint16_t, uint64_t>& part) {
+                            return part.first == value;
+                        });
+                    if (itr == check.parts.end())
+                        itr = check.parts.insert(check.parts.end(), { value, 0 });
+                    itr->second |= uint64_t(1) << i;
+                }
+                if (check.parts.size() < 2)
+                    continue;
+                m_MinCost = std::min(m_MinCost, check.cost);
+                m_Checks.push_back(std::move(check));
+            }
+        }
+
+        uint64_t all = m_Seeds.size() == 64 ? ~uint64_t(0)
+            : (uint64_t(1) << m_Seeds.size()) - 1;
+        m_Solutions.clear();
+        m_Splittable.clear();
+        EmdbTree tree{};
+        tree.terrain = terrain;
+        tree.spawn = spawn;
+        tree.root = Emit(all);
+        m_Trees.push_back(tree);
+    }
+}
+
+const SeedTreeBuilder::Solution& SeedTreeBuilder::Solve(uint64_t seeds) {
+    auto itr = m_Solutions.find(seeds);
+    if (itr != m_Solutions.end())
+        return itr->second;
+
+    Solution best{ 0, -1 };
+    uint32_t total = PopCount(seeds);
+    if (total < 2)
+        return m_Solutions[seeds] = best;
+
+    // 划分相同的检查只保留代价最低的，按下界升序尝试
+    struct Option {
+        int check;
+        float bound;
+        std::vector<uint64_t> parts;
+    };
+    std::vector<Option> options;
+    std::set<std::vector<uint64_t>> seen;
+    for (int c = 0; c < (int)m_Checks.size(); c++) {
+        Option option{ c, m_Checks[c].cost };
+        for (auto& part : m_Checks[c].parts) {
+            uint64_t sub = part.second & seeds;
+            if (!sub)
+                continue;
+            option.parts.push_back(sub);
+            // 只有还能继续区分的部分至少再花 m_MinCost，否则下界会高估而剪掉最优解
+            uint32_t count = PopCount(sub);
+            if (count > 1 && Splittable(sub))
+                option.bound += m_MinCost * count / total;
+        }
+        if (option.parts.size() < 2)
+            continue;
+        std::sort(option.parts.begin(), option.parts.end());
+        options.push_back(std::move(option));
+    }
+    std::sort(options.begin(), options.end(),
+        [this](const Option& l, const Option& r) {
+            if (l.bound != r.bound)
+                return l.bound < r.bound;
+            return m_Checks[l.check].cost < m_Checks[r.check].cost;
+        });
+
+    best.cost = FLT_MAX;
+    for (auto& option : options) {
+        if (option.bound >= best.cost)
+            break;
+        if (!seen.insert(option.parts).second)
+            continue;
+        float cost = m_Checks[option.check].cost;
+        for (uint64_t sub : option.parts) {
+            cost += Solve(sub).cost * PopCount(sub) / total;
+            if (cost >= best.cost)
+                break;
+        }
+        if (cost < best.cost)
+            best = { cost, option.check };
+    }
+    if (best.check < 0)
+        best.cost = 0;
+    return m_Solutions[seeds] = best;
+}
+
+bool SeedTreeBuilder::Splittable(uint64_t seeds) {
+    auto itr = m_Splittable.find(seeds);
+    if (itr != m_Splittable.end())
+        return itr->second;
+
+    bool splittable = false;
+    for (const auto& check : m_Checks) {
+        int parts = 0;
+        for (const auto& part : check.parts) {
+            if ((part.second & seeds) && ++parts > 1)
+                break;
+        }
+        if (parts > 1) {
+            splittable = true;
+            break;
+        }
+    }
+    return m_Splittable[seeds] = splittable;
+}
+
+uint32_t SeedTreeBuilder::Emit(uint64_t seeds) {
+    const Solution solution = Solve(seeds);
+    uint32_t id = (uint32_t)m_Nodes.size();
+    EmdbTreeNode node{};
+    node.type = eLocationTypeCount;
+    node.seed = m_Seeds[TrailingZeros(seeds)];
+    node.seedCount = (uint16_t)PopCount(seeds);
+    node.expected = solution.cost;
+    m_Nodes.push_back(node);
+    if (solution.check < 0)
+        return id;
+
+    const auto& check = m_Checks[solution.check];
+    std::vector<std::pair<uint16_t, uint64_t>> parts;
+    for (auto& part : check.parts) {
+        if (part.second & seeds)
+            parts.emplace_back(part.first, part.second & seeds);
+    }
+    uint32_t firstBranch = (uint32_t)m_Branches.size();
+    m_Branches.resize(m_Branches.size() + parts.size());
+    for (size_t i = 0; i < parts.size(); i++) {
+        uint32_t child = Emit(parts[i].second);
+        m_Branches[firstBranch + i] = { parts[i].first, 0, child };
+    }
+
+    auto& target = m_Nodes[id];
+    target.type = (uint16_t)check.type;
+    target.slot = check.slot;
+    target.branchCount = (uint32_t)parts.size();
+    target.firstBranch = firstBranch;
+    return id;
+}
+
+template<class T>
+static uint32_t Append(std::vector<char>& image, const std::vector<T>& data) {
+    image.resize((image.size() + 3) & ~size_t(3), 0);
+    uint32_t offset = (uint32_t)image.size();
+    const char* bytes = reinterpret_cast<const char*>(data.data());
+    image.insert(image.end(), bytes, bytes + sizeof(T) * data.size());
+    return offset;
+}
+
+void SeedTreeBuilder::Finish(std::vector<char>& image) const {
+    EmdbHeader header;
+    memcpy(&header, image.data(), sizeof(header));
+    header.treeCount = (uint32_t)m_Trees.size();
+    header.treeOffset = Append(image, m_Trees);
+    header.treeNodeCount = (uint32_t)m_Nodes.size();
+    header.treeNodeOffset = Append(image, m_Nodes);
+    header.treeBranchCount = (uint32_t)m_Branches.size();
+    header.treeBranchOffset = Append(image, m_Branches);
+    header.size = (uint32_t)image.size();
+    memcpy(image.data(), &header, sizeof(header));
+}
+
+bool SeedTreeWalker::Reset(const MapThumbnail& thumbnail, uint16_t spawn) {
+    Clear();
+    auto tree = thumbnail.Tree(spawn);
+    if (!tree)
+        return false;
+    m_Database = thumbnail.Database();
+    m_Node = &m_Database->TreeNode(tree->root);
+    return true;
+}
+
+bool SeedTreeWalker::Check(uint16_t value) {
+    if (!m_Node || IsLeaf())
+        return false;
+    for (uint32_t i = 0; i < m_Node->branchCount; i++) {
+        const auto& branch = m_Database->TreeBranch(m_Node->firstBranch + i);
+        if (branch.value == value) {
+            m_Node = &m_Database->TreeNode(branch.node);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "SeedIndex.h"
+
+// 决策树节点只存 LocationType，取对应的按地点取值字段
+SeedField GetLocationField(LocationType loc);
+
+// 离线构建每个 (地形, 落地点) 的识别决策树
+// 精确搜索使确定种子前的期望检查代价最小，检查代价可按离落地点的距离加权
+class SeedTreeBuilder {
+public:
+	// distanceWeight: 离落地点每 1000 像素额外计入的检查代价，0 表示只计次数
+	explicit SeedTreeBuilder(float distanceWeight = 0)
+		: m_DistanceWeight(distanceWeight) {}
+
+	void Build(const MapThumbnail& thumbnail, const SeedIndex& index, uint32_t terrain);
+	// 追加到 .emdb 镜像末尾并更新文件头
+	void Finish(std::vector<char>& image) const;
+
+private:
+	// 落地点内的种子最多 64 个，以位掩码表示种子子集
+	struct Check {
+		LocationType type;
+		uint16_t slot;
+		float cost;
+		std::vector<std::pair<uint16_t, uint64_t>> parts;
+	};
+	struct Solution {
+		float cost;
+		int check; // -1 表示无法再区分
+	};
+
+	const Solution& Solve(uint64_t seeds);
+	// 是否有检查能把 seeds 分成两部分以上，不能区分的子集代价为 0
+	bool Splittable(uint64_t seeds);
+	uint32_t Emit(uint64_t seeds);
+
+private:
+	float m_DistanceWeight = 0;
+	std::vector<EmdbTree> m_Trees;
+	std::vector<EmdbTreeNode> m_Nodes;
+	std::vector<EmdbTreeBranch> m_Branches;
+
+	// 当前落地点
+	std::vector<uint16_t> m_Seeds;
+	std::vector<Check> m_Checks;
+	float m_MinCost = 1;
+	std::unordered_map<uint64_t, Solution> m_Solutions;
+	std::unordered_map<uint64_t, bool> m_Splittable;
+};
+
+// 运行时沿决策树前进，不做任何搜索
+class SeedTreeWalker {
+public:
+	bool Reset(const MapThumbnail& thumbnail, uint16_t spawn);
+	void Clear() {
+		m_Database = nullptr;
+		m_Node = nullptr;
+	}
+	bool IsValid() const {
+		return m_Node != nullptr;
+	}
+	bool IsLeaf() const {
+		return m_Node->type >= eLocationTypeCount;
+	}
+	const EmdbTreeNode& Node() const {
+		return *m_Node;
+	}
+	SeedField Field() const {
+		return GetLocationField((LocationType)m_Node->type);
+	}
+	uint32_t BranchCount() const {
+		return m_Node->branchCount;
+	}
+	uint16_t BranchValue(uint32_t i) const {
+		return m_Database->TreeBranch(m_Node->firstBranch + i).value;
+	}
+	// 沿观察到的取值前进，没有对应分支返回 false
+	bool Check(uint16_t value);
+
+private:
+	const SeedDatabase* m_Database = nullptr;
+	const EmdbTreeNode* m_Node = nullptr;
+};
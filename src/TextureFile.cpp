@@ -0,0 +1,192 @@
+#include "TextureFile.h"
+#include <algorithm>
+#include <cstring>
+
+bool TextureFile::Open(const char* path) {
+    Close();
+    if (!m_File.Open(path))
+        return false;
+
+    size_t size = m_File.Size();
+    auto header = reinterpret_cast<const EmtexHeader*>(m_File.Data());
+    if (size < sizeof(EmtexHeader) || header->magic != EMTEX_MAGIC
+        || header->version != EMTEX_VERSION || header->size != size
+        || header->levelCount == 0 || header->levelCount > EMTEX_MAX_LEVELS) {
+        Close();
+        return false;
+    }
+    for (uint32_t i = 0; i < header->levelCount; i++) {
+        const auto& level = header->levels[i];
+        if ((uint64_t)level.offset + level.size > size
+            || (uint64_t)level.width * level.height * 4 != level.size) {
+            Close();
+            return false;
+        }
+    }
+    m_Header = header;
+    return true;
+}
+
+void TextureFile::Close() {
+    m_File.Close();
+    m_Header = nullptr;
+}
+
+void TextureFile::Premultiply(unsigned char* rgba, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        unsigned char* p = rgba + i * 4;
+        unsigned a = p[3];
+        p[0] = (unsigned char)((p[0] * a + 127) / 255);
+        p[1] = (unsigned char)((p[1] * a + 127) / 255);
+        p[2] = (unsigned char)((p[2] * a + 127) / 255);
+    }
+}
+
+// 2x2 盒式滤波，奇数边最后一行（列）与自身平均
+static void Downsample(const unsigned char* src, uint32_t width, uint32_t height,
+    unsigned char* dst, uint32_t dstWidth, uint32_t dstHeight) {
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        uint32_t y0 = std::min(y * 2, height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            uint32_t x0 = std::min(x * 2, width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; c++) {
+                unsigned sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c]
+                    + src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                dst[(y * dstWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void TextureFile::Compile(const unsigned char* rgba, int width, int height, std::vector<char>& image) {
+    EmtexHeader header{};
+    header.magic = EMTEX_MAGIC;
+    header.version = EMTEX_VERSION;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+
+    uint32_t offset = sizeof(EmtexHeader);
+    uint32_t w = header.width, h = header.height;
+    while (header.levelCount < EMTEX_MAX_LEVELS) {
+        auto& level = header.levels[header.levelCount++];
+        level = { offset, w, h, w * h * 4 };
+        offset += level.size;
+        if (w == 1 && h == 1)
+            break;
+        w = std::max(1u, w / 2);
+        h = std::max(1u, h / 2);
+    }
+    header.size = offset;
+
+    image.assign(offset, 0);
+    memcpy(image.data(), &header, sizeof(header));
+    auto level0 = reinterpret_cast<unsigned char*>(image.data() + header.levels[0].offset);
+    memcpy(level0, rgba, header.levels[0].size);
+    // 预乘后再降采样，半透明边缘不会混入透明像素的颜色
+    Premultiply(level0, (size_t)width * height);
+    for (uint32_t i = 1; i < header.levelCount; i++) {
+        const auto& src = header.levels[i - 1];
+        const auto& dst = header.levels[i];
+        Downsample(reinterpret_cast<unsigned char*>(image.data() + src.offset), src.width, src.height,
+            reinterpret_cast<unsigned char*>(image.data() + dst.offset), dst.width, dst.height);
+    }
+}
+
+bool TileFile::Open(const char* path) {
+    Close();
+    if (!m_File.Open(path))
+        return false;
+
+    size_t size = m_File.Size();
+    auto header = reinterpret_cast<const EmtileHeader*>(m_File.Data());
+    if (size < sizeof(EmtileHeader) || header->magic != EMTILES_MAGIC
+        || header->version != EMTILES_VERSION || header->size != size
+        || header->tileSize == 0 || header->width == 0 || header->height == 0
+        || header->levelCount == 0 || header->levelCount > EMTEX_MAX_LEVELS) {
+        Close();
+        return false;
+    }
+    uint64_t edge = header->tileSize + 2 * header->border;
+    if (sizeof(EmtileHeader) + header->tileCount * edge * edge * 4 != size) {
+        Close();
+        return false;
+    }
+    for (uint32_t i = 0; i < header->levelCount; i++) {
+        const auto& level = header->levels[i];
+        if ((uint64_t)level.firstTile + (uint64_t)level.columns * level.rows > header->tileCount
+            || level.columns * header->tileSize < level.width
+            || level.rows * header->tileSize < level.height) {
+            Close();
+            return false;
+        }
+    }
+    // 顶层须为单块瓦片，作为常驻的兜底
+    const auto& top = header->levels[header->levelCount - 1];
+    if (top.columns != 1 || top.rows != 1) {
+        Close();
+        return false;
+    }
+    m_Header = header;
+    return true;
+}
+
+void TileFile::Close() {
+    m_File.Close();
+    m_Header = nullptr;
+}
+
+void TileFile::Compile(const unsigned char* rgba, int width, int height, uint32_t tileSize, std::vector<char>& image) {
+    // 先生成完整的 mip 链，再把各层切成瓦片，直到某层只剩一块
+    std::vector<char> mips;
+    TextureFile::Compile(rgba, width, height, mips);
+    auto mipHeader = reinterpret_cast<const EmtexHeader*>(mips.data());
+
+    EmtileHeader header{};
+    header.magic = EMTILES_MAGIC;
+    header.version = EMTILES_VERSION;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.tileSize = tileSize;
+    header.border = EMTILES_BORDER;
+    for (uint32_t i = 0; i < mipHeader->levelCount; i++) {
+        const auto& mip = mipHeader->levels[i];
+        auto& level = header.levels[header.levelCount++];
+        level.width = mip.width;
+        level.height = mip.height;
+        level.columns = (mip.width + tileSize - 1) / tileSize;
+        level.rows = (mip.height + tileSize - 1) / tileSize;
+        level.firstTile = header.tileCount;
+        header.tileCount += level.columns * level.rows;
+        if (level.columns == 1 && level.rows == 1)
+            break;
+    }
+
+    uint32_t edge = tileSize + 2 * header.border;
+    uint32_t tileBytes = edge * edge * 4;
+    header.size = (uint32_t)sizeof(EmtileHeader) + header.tileCount * tileBytes;
+    image.assign(header.size, 0);
+    memcpy(image.data(), &header, sizeof(header));
+
+    auto tile = reinterpret_cast<unsigned char*>(image.data() + sizeof(EmtileHeader));
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        const auto& level = header.levels[i];
+        auto src = reinterpret_cast<const unsigned char*>(mips.data() + mipHeader->levels[i].offset);
+        for (uint32_t row = 0; row < level.rows; row++) {
+            for (uint32_t col = 0; col < level.columns; col++) {
+                // 超出图像的部分（含边框与右上边缘瓦片的空白）复制最近的边缘像素
+                int x0 = (int)(col * tileSize) - (int)header.border;
+                int y0 = (int)(row * tileSize) - (int)header.border;
+                for (uint32_t y = 0; y < edge; y++) {
+                    int sy = std::clamp(y0 + (int)y, 0, (int)level.height - 1);
+                    for (uint32_t x = 0; x < edge; x++) {
+                        int sx = std::clamp(x0 + (int)x, 0, (int)level.width - 1);
+                        memcpy(tile + (y * edge + x) * 4, src + ((size_t)sy * level.width + sx) * 4, 4);
+                    }
+                }
+                tile += tileBytes;
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MappedFile.h"
+
+// .emtex 布局（小端）：[EmtexHeader][level 0 像素][level 1 像素]...
+// 像素为预乘 alpha 的 RGBA8，行按 GL 纹理坐标自下而上存放，含完整 mip 链
+constexpr uint32_t EMTEX_MAGIC = 0x58544D45; // "EMTX"
+constexpr uint32_t EMTEX_VERSION = 1;
+constexpr uint32_t EMTEX_MAX_LEVELS = 16;
+
+// .emtiles 布局（小端）：[EmtileHeader][瓦片 0][瓦片 1]...
+// 每层按 mip 链缩小并切成 tileSize 见方的瓦片，最顶层只有一块；瓦片四周各带 border 像素的边缘复制，
+// 相邻瓦片双线性采样时不出现接缝。瓦片按层、自下而上逐行存放，大小固定为 (tileSize + 2 * border)^2 * 4
+constexpr uint32_t EMTILES_MAGIC = 0x4C544D45; // "EMTL"
+constexpr uint32_t EMTILES_VERSION = 1;
+constexpr uint32_t EMTILES_BORDER = 1;
+
+struct EmtexLevel {
+	uint32_t offset;
+	uint32_t width;
+	uint32_t height;
+	uint32_t size;
+};
+
+struct EmtexHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	EmtexLevel levels[EMTEX_MAX_LEVELS];
+};
+
+struct EmtileLevel {
+	uint32_t width;
+	uint32_t height;
+	uint32_t columns;
+	uint32_t rows;
+	uint32_t firstTile;
+};
+
+struct EmtileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t tileSize;
+	uint32_t border;
+	uint32_t tileCount;
+	uint32_t levelCount;
+	EmtileLevel levels[EMTEX_MAX_LEVELS];
+};
+
+class TextureFile {
+public:
+	// 映射 .emtex 文件，校验失败返回 false
+	bool Open(const char* path);
+	void Close();
+	bool IsValid() const {
+		return m_Header != nullptr;
+	}
+	const EmtexHeader& Header() const {
+		return *m_Header;
+	}
+	const unsigned char* Level(uint32_t i) const {
+		return reinterpret_cast<const unsigned char*>(m_File.Data() + m_Header->levels[i].offset);
+	}
+
+	// 由未预乘的 RGBA8 像素（行已自下而上）生成 .emtex 镜像
+	static void Compile(const unsigned char* rgba, int width, int height, std::vector<char>& image);
+	// 原地预乘 alpha
+	static void Premultiply(unsigned char* rgba, size_t pixelCount);
+
+private:
+	MappedFile m_File;
+	const EmtexHeader* m_Header = nullptr;
+};
+
+// 地图瓦片金字塔
+class TileFile {
+public:
+	// 映射 .emtiles 文件，校验失败返回 false
+	bool Open(const char* path);
+	void Close();
+	bool IsValid() const {
+		return m_Header != nullptr;
+	}
+	const EmtileHeader& Header() const {
+		return *m_Header;
+	}
+	uint32_t TileBytes() const {
+		uint32_t edge = m_Header->tileSize + 2 * m_Header->border;
+		return edge * edge * 4;
+	}
+	// 第 level 层第 y 行（自下而上）第 x 列的瓦片像素
+	const unsigned char* Tile(uint32_t level, uint32_t x, uint32_t y) const {
+		const auto& info = m_Header->levels[level];
+		size_t index = info.firstTile + (size_t)y * info.columns + x;
+		return reinterpret_cast<const unsigned char*>(m_File.Data() + sizeof(EmtileHeader) + index * TileBytes());
+	}
+
+	// 由未预乘的 RGBA8 像素（行已自下而上）生成 .emtiles 镜像
+	static void Compile(const unsigned char* rgba, int width, int height, uint32_t tileSize, std::vector<char>& image);
+
+private:
+	MappedFile m_File;
+	const EmtileHeader* m_Header = nullptr;
+};
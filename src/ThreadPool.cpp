@@ -0,0 +1,88 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+void ThreadPool::Start(unsigned threads) {
+    Stop();
+#ifdef THREAD_POOL_THREADS
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    m_Quit = false;
+    for (unsigned i = 0; i < threads; i++) {
+        m_Workers.emplace_back(&ThreadPool::WorkerMain, this, m_Generation);
+    }
+#else
+    (void)threads;
+#endif
+}
+
+void ThreadPool::Stop() {
+#ifdef THREAD_POOL_THREADS
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Wake.notify_all();
+    for (auto& worker : m_Workers) {
+        worker.join();
+    }
+    m_Workers.clear();
+#endif
+}
+
+void ThreadPool::Drain() {
+    for (uint32_t i = m_Next++; i < m_Count; i = m_Next++) {
+        (*m_Task)(i);
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const Task& task) {
+    m_Task = &task;
+    m_Count = count;
+    m_Next = 0;
+#ifdef THREAD_POOL_THREADS
+    // 任务数不多于一个时不必唤醒工作线程
+    if (count > 1 && !m_Workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Active = (unsigned)m_Workers.size();
+            m_Generation++;
+        }
+        m_Wake.notify_all();
+        Drain();
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this]() { return m_Active == 0; });
+        m_Task = nullptr;
+        return;
+    }
+#endif
+    Drain();
+    m_Task = nullptr;
+}
+
+void ThreadPool::WorkerMain(uint64_t generation) {
+#ifdef THREAD_POOL_THREADS
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this, generation]() {
+                return m_Quit || m_Generation != generation;
+            });
+            if (m_Quit)
+                return;
+            generation = m_Generation;
+        }
+        Drain();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Active == 0)
+                m_Done.notify_one();
+        }
+    }
+#else
+    (void)generation;
+#endif
+}
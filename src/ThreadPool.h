@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 未启用 pthread 的 Emscripten 构建没有工作线程，任务在调用线程中顺序执行
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define THREAD_POOL_THREADS
+#endif
+
+// 常驻工作线程的线程池：ParallelFor 把 [0, count) 分给工作线程与调用线程，全部完成后返回。
+// 同一时刻只允许一个线程调用 ParallelFor
+class ThreadPool {
+public:
+	using Task = std::function<void(uint32_t)>;
+
+	~ThreadPool();
+	// threads 为工作线程数（不含调用线程），0 为硬件线程数减一
+	void Start(unsigned threads = 0);
+	void Stop();
+	unsigned ThreadCount() const {
+#ifdef THREAD_POOL_THREADS
+		return (unsigned)m_Workers.size();
+#else
+		return 0;
+#endif
+	}
+
+	void ParallelFor(uint32_t count, const Task& task);
+
+private:
+	// generation 为启动时的任务代数，之后每次代数变化执行一轮
+	void WorkerMain(uint64_t generation);
+	// 领取并执行剩余的下标，直到全部领完
+	void Drain();
+
+private:
+	const Task* m_Task = nullptr;
+	uint32_t m_Count = 0;
+	std::atomic<uint32_t> m_Next{ 0 };
+#ifdef THREAD_POOL_THREADS
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::condition_variable m_Done;
+	uint64_t m_Generation = 0;
+	unsigned m_Active = 0; // 本轮尚未完成的工作线程数
+	bool m_Quit = false;
+#endif
+};